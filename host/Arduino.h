@@ -0,0 +1,79 @@
+/**
+ * @file Arduino.h
+ * @brief Minimal Arduino/ESP32 core stand-in for the host (native) build.
+ *
+ * @details Only the calls made by the DWIN driver are provided. Time is
+ * virtual: delay() and delayMicroseconds() advance a simulated clock instead
+ * of sleeping, so benchmark runs are fast and reproducible.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <algorithm>
+#include <string>
+
+#include <HardwareSerial.h>
+
+#define IRAM_ATTR
+
+using std::min;
+using std::max;
+
+//==============================================================================
+// TIME
+//==============================================================================
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+unsigned long millis();
+unsigned long micros();
+
+/**
+ * @brief Advances the virtual clock without counting it as driver dead time.
+ * @param us Microseconds to add (e.g. simulated UART transfer time).
+ */
+void host_advance_us(uint64_t us);
+
+/**
+ * @brief Total time spent inside delay()/delayMicroseconds() so far.
+ * @return Accumulated dead time in microseconds.
+ */
+uint64_t host_delay_us();
+
+//==============================================================================
+// GPIO (no-op on host; DWINScreen's chip select is framed by SPI transactions)
+//==============================================================================
+#define LOW 0
+#define HIGH 1
+#define OUTPUT 0x03
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+
+//==============================================================================
+// STRING (only what DWINScreen uses)
+//==============================================================================
+class String {
+private:
+    std::string text;
+
+public:
+    String(const char *str = "") : text(str) {}
+    const char *c_str() const { return text.c_str(); }
+    unsigned int length() const { return text.size(); }
+};
+
+//==============================================================================
+// ESP32 HARDWARE TIMER (no-op on host, ticks are driven by the bench)
+//==============================================================================
+typedef struct hw_timer_s hw_timer_t;
+
+hw_timer_t *timerBegin(uint8_t num, uint16_t divider, bool countUp);
+void timerAttachInterrupt(hw_timer_t *timer, void (*fn)(void), bool edge);
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarm_value, bool autoreload);
+void timerAlarmEnable(hw_timer_t *timer);
+
+extern HardwareSerial Serial;
@@ -0,0 +1,38 @@
+/**
+ * @file HardwareSerial.h
+ * @brief Host stand-in for the ESP32 HardwareSerial class.
+ *
+ * @details UART 0 prints to stdout (the USB `Serial` port on the board).
+ * Any other UART is wired to the T5UIC1 emulator: written bytes are parsed as
+ * DWIN frames and panel responses are returned by read().
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SERIAL_8N1 0x800001c
+
+class HardwareSerial {
+private:
+    int uartNr;
+    unsigned long baud;
+
+public:
+    HardwareSerial(int uart_nr);
+
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1);
+    size_t write(uint8_t value);
+    size_t write(const uint8_t *buffer, size_t size);
+    int available();
+    int availableForWrite();
+    int read();
+    int peek();
+    void flush();
+
+    size_t print(const char *str);
+    size_t print(long value);
+    size_t println(const char *str = "");
+    size_t println(long value);
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
@@ -0,0 +1,28 @@
+/**
+ * @file SPI.h
+ * @brief Host stand-in for the Arduino SPI class.
+ *
+ * @details Every transaction is handed to the DGUS emulator (dgus_emulator.h),
+ * which plays the panel DWINScreen talks to over SPI.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define MSBFIRST 1
+#define SPI_MODE0 0
+
+class SPISettings {
+public:
+    SPISettings(uint32_t clock = 1000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0) {}
+};
+
+class SPIClass {
+public:
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1);
+    void beginTransaction(SPISettings settings);
+    uint8_t transfer(uint8_t data);
+    void endTransaction();
+};
+
+extern SPIClass SPI;
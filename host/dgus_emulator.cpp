@@ -0,0 +1,83 @@
+/**
+ * @file dgus_emulator.cpp
+ * @brief DGUS VP memory and frame parser behind the host SPI stand-in.
+ */
+
+#include <string.h>
+#include <deque>
+#include <vector>
+#include "dgus_emulator.h"
+
+static uint16_t vp[0x10000];
+static std::vector<uint8_t> frame;      // Bytes clocked out in this transaction
+static std::deque<uint8_t> response;    // Bytes waiting to be clocked in
+static bool receiving = false;
+static dgus_emu_stats_t stats;
+
+void dgus_emu_init() {
+  memset(vp, 0, sizeof(vp));
+  frame.clear();
+  response.clear();
+  receiving = false;
+  memset(&stats, 0, sizeof(stats));
+}
+
+uint8_t dgus_emu_transfer(uint8_t data) {
+  if (frame.empty() && !receiving && data != 0x5A) receiving = true;
+  if (!receiving) {
+    frame.push_back(data);
+    return 0xFF;
+  }
+  if (response.empty()) return 0xFF;
+  uint8_t value = response.front();
+  response.pop_front();
+  return value;
+}
+
+void dgus_emu_end() {
+  bool was_receiving = receiving;
+  receiving = false;
+  if (was_receiving) return;
+
+  // 5A A5 len cmd addrH addrL data, len counting cmd, address and data
+  if (frame.size() < 6 || frame[1] != 0xA5 || frame[2] != frame.size() - 3) {
+    stats.bad_frames++;
+    frame.clear();
+    return;
+  }
+  uint16_t address = frame[4] << 8 | frame[5];
+  size_t data_len = frame.size() - 6;
+
+  if (frame[3] == 0x82) {
+    for (size_t i = 0; i < data_len; i++) {
+      uint16_t &word = vp[(uint16_t)(address + i / 2)];
+      word = (i & 1) ? (word & 0xFF00) | frame[6 + i] : (word & 0x00FF) | frame[6 + i] << 8;
+    }
+    stats.write_frames++;
+    if (data_len > stats.max_write_bytes) stats.max_write_bytes = data_len;
+  } else if (frame[3] == 0x83 && data_len == 1) {
+    uint8_t words = frame[6];
+    response.insert(response.end(), {0x5A, 0xA5, (uint8_t)(4 + 2 * words), 0x83, frame[4], frame[5], words});
+    for (uint8_t i = 0; i < words; i++) {
+      uint16_t word = vp[(uint16_t)(address + i)];
+      response.push_back(word >> 8);
+      response.push_back(word & 0xFF);
+    }
+    stats.read_frames++;
+  } else {
+    stats.bad_frames++;
+  }
+  frame.clear();
+}
+
+uint16_t dgus_emu_vp(uint16_t address) {
+  return vp[address];
+}
+
+void dgus_emu_set_vp(uint16_t address, uint16_t value) {
+  vp[address] = value;
+}
+
+const dgus_emu_stats_t* dgus_emu_get_stats() {
+  return &stats;
+}
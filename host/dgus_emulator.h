@@ -0,0 +1,48 @@
+/**
+ * @file dgus_emulator.h
+ * @brief Host-side emulator of a DGUS panel on the SPI bus, for DWINScreen.
+ *
+ * @details Each SPI transaction that starts with `5A A5` is parsed as one
+ * frame: 0x82 writes land in an emulated VP memory and 0x83 reads queue the
+ * `5A A5 len 83 addr n data` response. Any other transaction is the driver
+ * clocking a response in, and gets the queued bytes (0xFF once empty).
+ */
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+  uint32_t write_frames;       // 0x82 frames received
+  uint32_t read_frames;        // 0x83 frames received
+  uint32_t bad_frames;         // Frames with a wrong header, length or command
+  uint32_t max_write_bytes;    // Largest data field of a write frame
+} dgus_emu_stats_t;
+
+/**
+ * @brief Clears the VP memory, the pending responses and the counters.
+ */
+void dgus_emu_init();
+
+/**
+ * @brief Exchanges one byte of the current transaction.
+ * @param data Byte the driver clocks out.
+ * @return Byte the panel clocks back.
+ */
+uint8_t dgus_emu_transfer(uint8_t data);
+
+/**
+ * @brief Ends the current transaction and executes the frame it carried.
+ */
+void dgus_emu_end();
+
+/**
+ * @brief Word at a VP address, as the panel holds it.
+ */
+uint16_t dgus_emu_vp(uint16_t address);
+
+/**
+ * @brief Changes a word behind the driver's back, as the touch panel does.
+ */
+void dgus_emu_set_vp(uint16_t address, uint16_t value);
+
+const dgus_emu_stats_t* dgus_emu_get_stats();
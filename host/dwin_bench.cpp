@@ -0,0 +1,925 @@
+/**
+ * @file dwin_bench.cpp
+ * @brief Wire-cost benchmark for the DWIN LVGL driver, running on the host.
+ *
+ * @details Builds one of the standard screens, runs LVGL against the emulated
+ * panel and reports, for every dwin_disp_flush call, the bytes and frames put
+ * on the wire and the simulated transfer time. Every flushed pixel is also
+ * copied into a reference framebuffer, which is compared with the emulated
+ * panel so encoder changes are checked pixel-exact against LVGL's render.
+ *
+ * Usage: dwin_bench [--screen hmi|status|menu|scroll|icons|tiles|picture|gradient|bitmap] [--baud N] [--ms N] [--shadow BYTES] [--encoder NAME] [--quantize palette|tolerance LEVEL] [--quiet] [--ppm file] [--record trace]
+ *        dwin_bench --replay trace [--baud N] [--ppm file]
+ *        dwin_bench --kernel
+ *        dwin_bench --dgus
+ * The exit code is non-zero if any pixel differs (by more than the quantization
+ * error budget, with --quantize). --record writes the frames sent to a wire
+ * trace (see dwin_trace.h); --replay feeds a trace, recorded here or on the
+ * board, into the emulator instead of running LVGL. --kernel only times the
+ * encoder's analysis pass on synthetic blocks and prints the time per pixel.
+ * --dgus checks DWINScreen's write batching and read merging against an
+ * emulated DGUS panel on the SPI bus instead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include <Arduino.h>
+#include <lvgl.h>
+#include <dwin.h>
+#include <dwin_encoder.h>
+#include <dwin_draw.h>
+#include <dwin_atlas.h>
+#include <dwin_tiles.h>
+#include <dwin_telemetry.h>
+#include <dwin_trace.h>
+#include "dwin_emulator.h"
+#include "dgus_emulator.h"
+#include "DWIN_Screen.h"
+
+HardwareSerial DWINSerial(2);
+
+static uint16_t reference[DWIN_WIDTH * DWIN_HEIGHT];
+static void (*driver_flush_cb)(lv_disp_drv_t *, const lv_area_t *, lv_color_t *) = NULL;
+
+static bool quiet = false;
+static uint32_t flush_count = 0;
+static uint64_t flush_pixels = 0;
+static uint32_t mismatched_flushes = 0;
+
+//==============================================================================
+// STANDARD SCREENS
+//==============================================================================
+
+typedef struct {
+  const char *name;
+  void (*create)(void);
+  void (*step)(uint32_t elapsed_ms);   // Optional periodic update, may be NULL
+} bench_screen_t;
+
+static lv_obj_t *status_hotend = NULL;
+static lv_obj_t *status_bar = NULL;
+static lv_obj_t *scroll_list = NULL;
+
+/**
+ * @brief Same widgets as create_test_hmi() in main.ino.
+ */
+static void screen_hmi_create() {
+  lv_obj_t *scr = lv_scr_act();
+  lv_obj_set_style_bg_color(scr, lv_color_black(), LV_PART_MAIN);
+
+  lv_obj_t *label = lv_label_create(scr);
+  lv_label_set_text(label, "ESP32 + DWIN + LVGL");
+  lv_obj_set_style_text_color(label, lv_color_white(), LV_PART_MAIN);
+  lv_obj_set_style_text_font(label, &lv_font_montserrat_14, LV_PART_MAIN);
+  lv_obj_align(label, LV_ALIGN_TOP_MID, 0, 20);
+
+  lv_obj_t *btn = lv_btn_create(scr);
+  lv_obj_align(btn, LV_ALIGN_CENTER, 0, -50);
+  lv_obj_set_size(btn, 150, 50);
+  lv_obj_set_style_bg_color(btn, lv_color_hex(0x007BFF), LV_PART_MAIN);
+  lv_obj_set_style_shadow_width(btn, 10, LV_PART_MAIN);
+  lv_obj_set_style_shadow_color(btn, lv_color_hex(0x0056b3), LV_PART_MAIN);
+
+  lv_obj_t *btn_label = lv_label_create(btn);
+  lv_label_set_text(btn_label, "Press Me");
+  lv_obj_set_style_text_color(btn_label, lv_color_white(), LV_PART_MAIN);
+  lv_obj_center(btn_label);
+
+  lv_obj_t *slider = lv_slider_create(scr);
+  lv_obj_set_width(slider, 200);
+  lv_obj_align(slider, LV_ALIGN_CENTER, 0, 50);
+  lv_slider_set_value(slider, 70, LV_ANIM_ON);
+  lv_obj_set_style_bg_color(slider, lv_color_hex(0x00FF00), LV_PART_INDICATOR);
+}
+
+/**
+ * @brief Printer status page: temperatures, progress bar and a changing digit.
+ */
+static void screen_status_create() {
+  lv_obj_t *scr = lv_scr_act();
+  lv_obj_set_style_bg_color(scr, lv_color_hex(0x101820), LV_PART_MAIN);
+
+  lv_obj_t *title = lv_label_create(scr);
+  lv_label_set_text(title, "Printing: benchy.gcode");
+  lv_obj_set_style_text_color(title, lv_color_white(), LV_PART_MAIN);
+  lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 10);
+
+  status_hotend = lv_label_create(scr);
+  lv_label_set_text(status_hotend, "Hotend: 200 / 200 C");
+  lv_obj_set_style_text_color(status_hotend, lv_color_hex(0xFF8000), LV_PART_MAIN);
+  lv_obj_set_style_text_font(status_hotend, &lv_font_montserrat_16, LV_PART_MAIN);
+  lv_obj_align(status_hotend, LV_ALIGN_TOP_LEFT, 10, 60);
+
+  lv_obj_t *bed = lv_label_create(scr);
+  lv_label_set_text(bed, "Bed: 60 / 60 C");
+  lv_obj_set_style_text_color(bed, lv_color_hex(0x00A0FF), LV_PART_MAIN);
+  lv_obj_set_style_text_font(bed, &lv_font_montserrat_16, LV_PART_MAIN);
+  lv_obj_align(bed, LV_ALIGN_TOP_LEFT, 10, 90);
+
+  status_bar = lv_bar_create(scr);
+  lv_obj_set_size(status_bar, 240, 20);
+  lv_obj_align(status_bar, LV_ALIGN_TOP_MID, 0, 140);
+  lv_bar_set_value(status_bar, 42, LV_ANIM_OFF);
+}
+
+static void screen_status_step(uint32_t elapsed_ms) {
+  static uint32_t last_update = 0;
+  if (elapsed_ms - last_update < 1000) return;
+  last_update = elapsed_ms;
+  lv_label_set_text_fmt(status_hotend, "Hotend: %d / 200 C", 198 + (int)(elapsed_ms / 1000) % 4);
+  lv_bar_set_value(status_bar, 42 + (int)(elapsed_ms / 1000), LV_ANIM_OFF);
+}
+
+/**
+ * @brief Menu page: a column of flat buttons, like the printer's main menu.
+ */
+static void screen_menu_create() {
+  static const char *items[] = {"Print", "Prepare", "Control", "Info", "Move", "Home", "Level", "Filament"};
+  lv_obj_t *scr = lv_scr_act();
+  lv_obj_set_style_bg_color(scr, lv_color_black(), LV_PART_MAIN);
+
+  for (int i = 0; i < 8; i++) {
+    lv_obj_t *btn = lv_btn_create(scr);
+    lv_obj_set_size(btn, 252, 48);
+    lv_obj_set_pos(btn, 10, 10 + i * 58);
+    lv_obj_set_style_radius(btn, 0, LV_PART_MAIN);
+    lv_obj_set_style_shadow_width(btn, 0, LV_PART_MAIN);
+    lv_obj_set_style_bg_color(btn, lv_color_hex(0x334455), LV_PART_MAIN);
+
+    lv_obj_t *label = lv_label_create(btn);
+    lv_label_set_text(label, items[i]);
+    lv_obj_set_style_text_color(label, lv_color_white(), LV_PART_MAIN);
+    lv_obj_center(label);
+  }
+}
+
+/**
+ * @brief Scrolling menu: a long list scrolled a few pixels at a time.
+ */
+static void screen_scroll_create() {
+  lv_obj_t *scr = lv_scr_act();
+  lv_obj_set_style_bg_color(scr, lv_color_black(), LV_PART_MAIN);
+
+  scroll_list = lv_obj_create(scr);
+  lv_obj_set_size(scroll_list, 252, 300);
+  lv_obj_set_pos(scroll_list, 10, 90);
+  lv_obj_set_style_bg_color(scroll_list, lv_color_hex(0x101820), LV_PART_MAIN);
+  lv_obj_set_style_border_width(scroll_list, 0, LV_PART_MAIN);
+  lv_obj_set_style_radius(scroll_list, 0, LV_PART_MAIN);
+
+  for (int i = 0; i < 20; i++) {
+    lv_obj_t *btn = lv_btn_create(scroll_list);
+    lv_obj_set_size(btn, 220, 40);
+    lv_obj_set_pos(btn, 0, i * 50);
+    lv_obj_set_style_radius(btn, 0, LV_PART_MAIN);
+    lv_obj_set_style_shadow_width(btn, 0, LV_PART_MAIN);
+    lv_obj_set_style_bg_color(btn, lv_color_hex(0x334455), LV_PART_MAIN);
+
+    lv_obj_t *label = lv_label_create(btn);
+    lv_label_set_text_fmt(label, "Item %d", i + 1);
+    lv_obj_set_style_text_color(label, lv_color_white(), LV_PART_MAIN);
+    lv_obj_center(label);
+  }
+  dwin_scroll_attach(scroll_list);
+}
+
+static void screen_scroll_step(uint32_t elapsed_ms) {
+  static uint32_t last_step = 0;
+  static int steps = 0;
+  if (elapsed_ms - last_step < 50 || steps >= 40) return;
+  last_step = elapsed_ms;
+  steps++;
+  lv_obj_scroll_by(scroll_list, 0, -8, LV_ANIM_OFF);
+}
+
+/**
+ * @brief Status icons drawn from a sprite atlas in the panel's VRAM.
+ * @details The emulated panel flash holds picture 0 with three 32x32 icons in
+ * its top row; it is decoded into VRAM page 1 and the icons are copied from there.
+ */
+static void screen_icons_create() {
+  static uint16_t picture[DWIN_WIDTH * DWIN_HEIGHT];
+  static const uint16_t colors[] = {0xF800, 0xFD20, 0x041F};
+  for (int i = 0; i < 3; i++) {
+    for (int y = 0; y < 32; y++) {
+      for (int x = 0; x < 32; x++) {
+        bool ring = (x - 16) * (x - 16) + (y - 16) * (y - 16) < 14 * 14;
+        picture[y * DWIN_WIDTH + i * 32 + x] = ring ? colors[i] : 0x0000;
+      }
+    }
+  }
+  dwin_emu_flash_picture(0, picture);
+  dwin_atlas_load(1, 0);
+
+  static const char *names[] = {"hotend", "bed", "fan"};
+  lv_obj_t *scr = lv_scr_act();
+  lv_obj_set_style_bg_color(scr, lv_color_hex(0x101820), LV_PART_MAIN);
+  for (int i = 0; i < 3; i++) {
+    int sprite = dwin_atlas_add(1, names[i], i * 32, 0, 32, 32);
+    lv_obj_t *img = lv_img_create(scr);
+    lv_img_set_src(img, dwin_atlas_img_src(sprite));
+    lv_obj_set_pos(img, 20, 60 + i * 50);
+
+    lv_obj_t *label = lv_label_create(scr);
+    lv_label_set_text(label, names[i]);
+    lv_obj_set_style_text_color(label, lv_color_white(), LV_PART_MAIN);
+    lv_obj_set_pos(label, 70, 68 + i * 50);
+  }
+}
+
+static lv_obj_t *tiles_boxes[6];
+static lv_img_dsc_t tiles_states[2];
+
+/**
+ * @brief Checkboxes toggled one by one, drawn by LVGL from images whose pixels
+ * are also in a picture of the panel flash, so the tile cache finds them in VRAM.
+ */
+static void screen_tiles_create() {
+  static uint16_t picture[DWIN_WIDTH * DWIN_HEIGHT];
+  static uint16_t states[2][32 * 32];
+  for (int s = 0; s < 2; s++) {
+    for (int y = 0; y < 32; y++) {
+      for (int x = 0; x < 32; x++) {
+        bool border = x < 3 || y < 3 || x > 28 || y > 28;
+        bool check = s && x > 8 && x < 24 && y > 8 && y < 24 && (x + y) % 3;
+        states[s][y * 32 + x] = border ? 0xFFFF : check ? 0x07E0 : 0x2104;
+        picture[y * DWIN_WIDTH + s * 32 + x] = states[s][y * 32 + x];
+      }
+    }
+    tiles_states[s].header.cf = LV_IMG_CF_TRUE_COLOR;
+    tiles_states[s].header.w = 32;
+    tiles_states[s].header.h = 32;
+    tiles_states[s].data_size = sizeof(states[s]);
+    tiles_states[s].data = (const uint8_t *)states[s];
+  }
+  dwin_emu_flash_picture(0, picture);
+  dwin_atlas_load(1, 0);
+  dwin_tiles_index(1, 0, 0, 64, 32, picture, DWIN_WIDTH);
+
+  lv_obj_t *scr = lv_scr_act();
+  lv_obj_set_style_bg_color(scr, lv_color_hex(0x101820), LV_PART_MAIN);
+  for (int i = 0; i < 6; i++) {
+    tiles_boxes[i] = lv_img_create(scr);
+    lv_img_set_src(tiles_boxes[i], &tiles_states[i % 2]);
+    lv_obj_set_pos(tiles_boxes[i], 32, 64 + i * 48);   // On the 16 px tile grid
+
+    lv_obj_t *label = lv_label_create(scr);
+    lv_label_set_text_fmt(label, "Option %d", i + 1);
+    lv_obj_set_style_text_color(label, lv_color_white(), LV_PART_MAIN);
+    lv_obj_set_pos(label, 80, 72 + i * 48);
+  }
+}
+
+static void screen_tiles_step(uint32_t elapsed_ms) {
+  static uint32_t last_toggle = 0;
+  static int toggles = 0;
+  if (elapsed_ms - last_toggle < 500) return;
+  last_toggle = elapsed_ms;
+  lv_obj_t *box = tiles_boxes[toggles % 6];
+  lv_img_set_src(box, lv_img_get_src(box) == &tiles_states[0] ? &tiles_states[1] : &tiles_states[0]);
+  toggles++;
+}
+
+static lv_obj_t *picture_img = NULL;
+
+/**
+ * @brief Fills a picture of the emulated panel flash with a photo-like
+ * pattern, which costs the pixel encoders the most.
+ */
+static void bench_flash_photo(uint8_t id, uint32_t seed) {
+  static uint16_t picture[DWIN_WIDTH * DWIN_HEIGHT];
+  for (int y = 0; y < DWIN_HEIGHT; y++) {
+    for (int x = 0; x < DWIN_WIDTH; x++) {
+      seed = seed * 1103515245u + 12345u;
+      uint8_t noise = (seed >> 16) & 0x07;
+      uint8_t r = (x * 31 / DWIN_WIDTH + noise) & 0x1F;
+      uint8_t g = (y * 63 / DWIN_HEIGHT + noise) & 0x3F;
+      uint8_t b = ((x + y) * 31 / (DWIN_WIDTH + DWIN_HEIGHT)) & 0x1F;
+      picture[y * DWIN_WIDTH + x] = (r << 11) | (g << 5) | b;
+    }
+  }
+  dwin_emu_flash_picture(id, picture);
+}
+
+/**
+ * @brief Full-screen splash picture, replaced after two seconds by a print
+ * thumbnail from another picture, both decoded by the panel.
+ */
+static void screen_picture_create() {
+  bench_flash_photo(1, 1);
+  bench_flash_photo(2, 2);
+  dwin_atlas_add_picture(1, "splash", 0, 0, DWIN_WIDTH, DWIN_HEIGHT);
+  dwin_atlas_add_picture(2, "thumbnail", 0, 0, 128, 128);
+
+  picture_img = lv_img_create(lv_scr_act());
+  lv_img_set_src(picture_img, dwin_atlas_img_src(dwin_atlas_find("splash")));
+  lv_obj_set_pos(picture_img, 0, 0);
+}
+
+static void screen_picture_step(uint32_t elapsed_ms) {
+  if (elapsed_ms < 2000 || !picture_img) return;
+  lv_obj_t *scr = lv_scr_act();
+  lv_obj_clean(scr);
+  lv_obj_set_style_bg_color(scr, lv_color_hex(0x101820), LV_PART_MAIN);
+
+  picture_img = lv_img_create(scr);
+  lv_img_set_src(picture_img, dwin_atlas_img_src(dwin_atlas_find("thumbnail")));
+  lv_obj_set_pos(picture_img, 72, 40);
+
+  lv_obj_t *label = lv_label_create(scr);
+  lv_label_set_text(label, "benchy.gcode");
+  lv_obj_set_style_text_color(label, lv_color_white(), LV_PART_MAIN);
+  lv_obj_set_pos(label, 72, 190);
+  picture_img = NULL;
+}
+
+/**
+ * @brief Full-width vertical gradient behind a horizontal gradient panel.
+ */
+static void screen_gradient_create() {
+  lv_obj_t *scr = lv_scr_act();
+  lv_obj_set_style_bg_color(scr, lv_color_hex(0x000000), LV_PART_MAIN);
+  lv_obj_set_style_bg_grad_color(scr, lv_color_hex(0x0050A0), LV_PART_MAIN);
+  lv_obj_set_style_bg_grad_dir(scr, LV_GRAD_DIR_VER, LV_PART_MAIN);
+
+  lv_obj_t *panel = lv_obj_create(scr);
+  lv_obj_set_size(panel, 252, 120);
+  lv_obj_set_pos(panel, 10, 180);
+  lv_obj_set_style_radius(panel, 0, LV_PART_MAIN);
+  lv_obj_set_style_border_width(panel, 0, LV_PART_MAIN);
+  lv_obj_set_style_bg_color(panel, lv_color_hex(0xFF8000), LV_PART_MAIN);
+  lv_obj_set_style_bg_grad_color(panel, lv_color_hex(0x400000), LV_PART_MAIN);
+  lv_obj_set_style_bg_grad_dir(panel, LV_GRAD_DIR_HOR, LV_PART_MAIN);
+}
+
+/**
+ * @brief Two-color stripes whose rows pack into 1 bpp bytes that spell the frame
+ * tail, within one row and across two, so the bitmap encoder must avoid it.
+ */
+static void screen_bitmap_create() {
+  static uint16_t stripes[32 * 8];
+  static lv_img_dsc_t stripes_img;
+  static const uint8_t rows[8][4] = {
+    {0xCC, 0x33, 0xC3, 0x3C}, {0x00, 0x00, 0x00, 0x00},
+    {0x00, 0x00, 0xCC, 0x33}, {0xC3, 0x3C, 0x00, 0x00},
+    {0x00, 0xCC, 0x33, 0xC3}, {0x3C, 0x00, 0x00, 0x00},
+    {0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x00, 0x00},
+  };
+  for (int y = 0; y < 8; y++) {
+    for (int x = 0; x < 32; x++) {
+      stripes[y * 32 + x] = rows[y][x / 8] & (0x80 >> (x % 8)) ? 0xFFFF : 0x0000;
+    }
+  }
+  stripes_img.header.cf = LV_IMG_CF_TRUE_COLOR;
+  stripes_img.header.w = 32;
+  stripes_img.header.h = 8;
+  stripes_img.data_size = sizeof(stripes);
+  stripes_img.data = (const uint8_t *)stripes;
+
+  lv_obj_t *scr = lv_scr_act();
+  lv_obj_set_style_bg_color(scr, lv_color_hex(0x000000), LV_PART_MAIN);
+  for (int i = 0; i < 8; i++) {
+    lv_obj_t *img = lv_img_create(scr);
+    lv_img_set_src(img, &stripes_img);
+    lv_obj_set_pos(img, 8 + (i % 4) * 64, 40 + (i / 4) * 96);
+  }
+}
+
+static const bench_screen_t screens[] = {
+  {"hmi", screen_hmi_create, NULL},
+  {"status", screen_status_create, screen_status_step},
+  {"menu", screen_menu_create, NULL},
+  {"scroll", screen_scroll_create, screen_scroll_step},
+  {"icons", screen_icons_create, NULL},
+  {"tiles", screen_tiles_create, screen_tiles_step},
+  {"picture", screen_picture_create, screen_picture_step},
+  {"gradient", screen_gradient_create, NULL},
+  {"bitmap", screen_bitmap_create, NULL},
+};
+
+//==============================================================================
+// FLUSH INSTRUMENTATION
+//==============================================================================
+
+/**
+ * @brief Tells whether a pixel the panel drew from its own memory can be
+ * compared with LVGL's render.
+ * @note LVGL never rendered glyphs of the panel fonts or sprites; tiles copied
+ * from VRAM are LVGL's pixels and are checked, unless sprites were drawn too.
+ */
+static bool bench_skip_pixel(uint8_t mask) {
+  return mask == DWIN_EMU_MASK_GLYPH || (mask == DWIN_EMU_MASK_COPY && dwin_atlas_get_stats()->draws > 0);
+}
+
+/**
+ * @brief Compares a panel pixel with LVGL's, allowing the quantization error.
+ */
+static bool bench_pixel_differs(uint16_t panel, uint16_t lvgl) {
+  return panel != lvgl && dwin_quantize_error(panel, lvgl) > dwin_quantize_max_error();
+}
+
+/**
+ * @brief Wraps the driver's flush callback to measure and verify each flush.
+ */
+static void bench_flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p) {
+  int32_t width = lv_area_get_width(area);
+  int32_t height = lv_area_get_height(area);
+
+  for (int32_t y = 0; y < height; y++) {
+    for (int32_t x = 0; x < width; x++) {
+      int32_t sx = area->x1 + x, sy = area->y1 + y;
+      if (sx >= 0 && sy >= 0 && sx < DWIN_WIDTH && sy < DWIN_HEIGHT) {
+        reference[sy * DWIN_WIDTH + sx] = lv_color_to16(color_p[y * width + x]);
+      }
+    }
+  }
+
+  // Strings, sprites and tiles drawn by the panel are marked per flush; forget the old ones here.
+  uint8_t *native_mask = dwin_emu_native_mask();
+  for (int32_t y = max((int32_t)area->y1, (int32_t)0); y <= min((int32_t)area->y2, (int32_t)DWIN_HEIGHT - 1); y++) {
+    memset(&native_mask[y * DWIN_WIDTH + area->x1], 0, width);
+  }
+
+  dwin_emu_stats_t before = *dwin_emu_get_stats();
+  uint64_t delay_before = host_delay_us();
+
+  driver_flush_cb(drv, area, color_p);
+
+  const dwin_emu_stats_t *after = dwin_emu_get_stats();
+  uint64_t bytes = after->bytes - before.bytes;
+  uint32_t frames = after->frames - before.frames;
+  uint64_t delay_us = host_delay_us() - delay_before;
+
+  uint32_t mismatches = 0;
+  for (int32_t y = area->y1; y <= area->y2; y++) {
+    for (int32_t x = area->x1; x <= area->x2; x++) {
+      if (bench_skip_pixel(native_mask[y * DWIN_WIDTH + x])) continue;
+      if (bench_pixel_differs(dwin_emu_get_pixel(x, y), reference[y * DWIN_WIDTH + x])) mismatches++;
+    }
+  }
+  if (mismatches) mismatched_flushes++;
+
+  flush_count++;
+  flush_pixels += (uint64_t)width * height;
+  if (!quiet) {
+    dwin_flush_record_t record = {};
+    dwin_telemetry_history(&record, 1);
+    printf("flush %4u (%3d,%3d)-(%3d,%3d) %6d px: %8llu B %6u frames  wire %9.1f ms  delay %7.1f ms  encode %6u us  %s\n",
+           flush_count, area->x1, area->y1, area->x2, area->y2, width * height,
+           (unsigned long long)bytes, frames, dwin_emu_wire_us(bytes) / 1000.0, delay_us / 1000.0,
+           record.encode_us, mismatches ? "MISMATCH" : "ok");
+  }
+}
+
+//==============================================================================
+// ANALYSIS KERNEL MICROBENCHMARK
+//==============================================================================
+
+#define KERNEL_BLOCK_ROWS 40
+#define KERNEL_RUN_MS 200
+
+static uint64_t kernel_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/**
+ * @brief Fills a DWIN_WIDTH x KERNEL_BLOCK_ROWS block with one of the patterns
+ * a flush typically carries.
+ */
+static void kernel_fill(lv_color_t *px, const char *pattern) {
+  uint32_t seed = 12345;
+  for (int32_t y = 0; y < KERNEL_BLOCK_ROWS; y++) {
+    for (int32_t x = 0; x < DWIN_WIDTH; x++) {
+      seed = seed * 1103515245u + 12345u;
+      lv_color_t *c = &px[y * DWIN_WIDTH + x];
+      if (!strcmp(pattern, "fill")) {
+        *c = lv_color_hex(0x203040);
+      } else if (!strcmp(pattern, "gradient")) {
+        *c = lv_color_make(0, y * 2, 64 + y * 4);
+      } else if (!strcmp(pattern, "text")) {
+        // Glyph-like strokes of 1-3 px with an anti-aliasing shade
+        bool ink = ((seed >> 16) % 100) < 15 || (x > 0 && (c - 1)->full != px[y * DWIN_WIDTH].full && (seed >> 8) % 3);
+        *c = x == 0 || !ink ? lv_color_hex(0x000000) : ((seed >> 20) % 4 ? lv_color_hex(0xFFFFFF) : lv_color_hex(0x808080));
+      } else {
+        c->full = seed >> 16;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Times dwin_encoder_choose() (the analysis pass and cost model) on
+ * synthetic blocks and prints the time per pixel.
+ */
+static void kernel_bench() {
+  static lv_color_t block[DWIN_WIDTH * KERNEL_BLOCK_ROWS];
+  static const char *const patterns[] = {"fill", "gradient", "text", "noise"};
+  const uint32_t block_px = DWIN_WIDTH * KERNEL_BLOCK_ROWS;
+
+  printf("analysis kernel, %dx%d blocks, %s colors\n", DWIN_WIDTH, KERNEL_BLOCK_ROWS,
+         DWIN_COLOR_NATIVE ? "native" : "converted");
+  for (size_t p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++) {
+    kernel_fill(block, patterns[p]);
+    uint32_t cost = 0;
+    dwin_encoding_t encoding = dwin_encoder_choose(block, DWIN_WIDTH, DWIN_WIDTH, KERNEL_BLOCK_ROWS, &cost);
+
+    uint64_t blocks = 0;
+    uint64_t cycles_start = kernel_cycles();
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::duration::zero();
+    do {
+      for (int i = 0; i < 64; i++) {
+        dwin_encoder_choose(block, DWIN_WIDTH, DWIN_WIDTH, KERNEL_BLOCK_ROWS, &cost);
+      }
+      blocks += 64;
+      elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(KERNEL_RUN_MS));
+    uint64_t cycles = kernel_cycles() - cycles_start;
+
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+    printf("  %-9s %-7s %6.2f ns/px", patterns[p], dwin_encoding_name(encoding), ns / (blocks * block_px));
+    if (cycles) printf("  %6.2f cycles/px", (double)cycles / (blocks * block_px));
+    printf("\n");
+  }
+}
+
+//==============================================================================
+// DGUS (SPI) CHECK
+//==============================================================================
+
+static DWINScreen *dgus_screen = NULL;
+static uint32_t dgus_reads = 0;
+static uint32_t dgus_wrong_reads = 0;
+
+static bool dgus_expect(bool ok, const char *what) {
+  printf("  %-44s %s\n", what, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+/**
+ * @brief Counts a completed read and whether its words match the panel's.
+ */
+static void dgus_read_cb(uint16_t address, const uint16_t *values, uint8_t words, void *ctx) {
+  bool ok = values && words == (uintptr_t)ctx;
+  for (uint8_t i = 0; ok && i < words; i++) {
+    ok = values[i] == dgus_emu_vp(address + i);
+  }
+  dgus_reads++;
+  if (!ok) dgus_wrong_reads++;
+}
+
+/**
+ * @brief Like dgus_read_cb(), and also reads another address and queues a new
+ * read from inside the callback.
+ */
+static void dgus_nested_cb(uint16_t address, const uint16_t *values, uint8_t words, void *ctx) {
+  dgus_read_cb(address, values, words, ctx);
+  if (dgus_screen->readVariable(0x3200) != dgus_emu_vp(0x3200)) dgus_wrong_reads++;
+  dgus_screen->requestVariable(0x3201, 1, dgus_read_cb, (void *)1);
+  dgus_screen->poll();
+}
+
+/**
+ * @brief Drives DWINScreen (src/DWIN_Screen.cpp) against the emulated DGUS
+ * panel: batched writes merged into runs and split at the frame limit, and
+ * merged reads sliced back into each request.
+ * @return 0 if every check passed, 1 otherwise.
+ */
+static int dgus_check() {
+  bool ok = true;
+  dgus_emu_init();
+  DWINScreen screen;
+  dgus_screen = &screen;
+  screen.begin();
+  const dgus_emu_stats_t *stats = dgus_emu_get_stats();
+
+  // Out-of-order writes to consecutive addresses go out as one frame
+  screen.beginBatch();
+  static const uint8_t order[] = {3, 0, 4, 2, 1};
+  for (uint8_t i : order) screen.writeVariable(0x1000 + i, (uint16_t)(0x1100 + i));
+  screen.endBatch();
+  bool merged = stats->write_frames == 1;
+  for (uint16_t i = 0; i < 5; i++) merged = merged && dgus_emu_vp(0x1000 + i) == 0x1100 + i;
+  ok &= dgus_expect(merged, "batched run merged into one frame");
+
+  // 200 bytes of text and 30 longs after it: a full 252 byte frame and the rest
+  char text[200];
+  memset(text, 'a', sizeof(text) - 1);
+  text[sizeof(text) - 1] = '\0';
+  screen.beginBatch();
+  screen.writeText(0x2000, text);
+  for (int32_t i = 0; i < 30; i++) screen.writeVariable(0x2064 + 2 * i, (int32_t)(0x00010000 * i + i));
+  screen.endBatch();
+  bool split = stats->write_frames == 3 && stats->max_write_bytes == DWIN_MAX_FRAME_DATA;
+  for (int32_t i = 0; i < 30; i++) split = split && dgus_emu_vp(0x2064 + 2 * i) == i && dgus_emu_vp(0x2065 + 2 * i) == i;
+  split = split && dgus_emu_vp(0x2000) == ('a' << 8 | 'a') && dgus_emu_vp(0x2063) == ('a' << 8);
+  ok &= dgus_expect(split, "run split at the 252 byte frame limit");
+
+  // Overlapping and touching reads share a frame; each callback gets its slice
+  for (uint16_t i = 0; i < 0x300; i++) dgus_emu_set_vp(0x3000 + i, 0xA000 + i);
+  screen.requestVariable(0x3010, 1, dgus_read_cb, (void *)1);
+  screen.requestVariable(0x3000, 2, dgus_read_cb, (void *)2);
+  screen.requestVariable(0x3001, 3, dgus_read_cb, (void *)3);
+  screen.requestVariable(0x3004, 1, dgus_read_cb, (void *)1);
+  screen.requestVariable(0x3100, DWIN_MAX_READ_WORDS, dgus_read_cb, (void *)DWIN_MAX_READ_WORDS);
+  screen.requestVariable(0x3140, DWIN_MAX_READ_WORDS, dgus_read_cb, (void *)DWIN_MAX_READ_WORDS);
+  screen.poll();
+  delay(DWIN_READ_DELAY_MS);
+  screen.poll();
+  ok &= dgus_expect(stats->read_frames == 4 && dgus_reads == 6 && dgus_wrong_reads == 0,
+                    "reads merged and sliced per request");
+
+  // A callback that reads again, before the other responses were taken
+  dgus_reads = 0;
+  screen.requestVariable(0x3000, 1, dgus_nested_cb, (void *)1);
+  screen.requestVariable(0x3050, 1, dgus_read_cb, (void *)1);
+  screen.poll();
+  delay(DWIN_READ_DELAY_MS);
+  screen.poll();
+  delay(DWIN_READ_DELAY_MS);
+  screen.poll();
+  ok &= dgus_expect(dgus_reads == 3 && dgus_wrong_reads == 0 && !screen.readsPending() &&
+                    screen.getStats().readErrors == 0 && stats->bad_frames == 0,
+                    "reads issued from a read callback");
+
+  dgus_screen = NULL;
+  printf("dgus check %s\n", ok ? "ok" : "FAIL");
+  return ok ? 0 : 1;
+}
+
+//==============================================================================
+// WIRE TRACE REPLAY
+//==============================================================================
+
+static void bench_trace_sink(const uint8_t *data, size_t len, void *ctx) {
+  fwrite(data, 1, len, (FILE *)ctx);
+}
+
+/**
+ * @brief Feeds a wire trace into the emulator and reports what it carried.
+ * @param baud Baud rate to time the wire with; 0 uses the recorded one.
+ * @return 0, or 1 if the trace cannot be read.
+ */
+static int replay_trace(const char *path, uint32_t baud, const char *ppm_path) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "cannot read %s\n", path);
+    return 1;
+  }
+  fseek(f, 0, SEEK_END);
+  size_t size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  uint8_t *trace = (uint8_t *)malloc(size ? size : 1);
+  size = fread(trace, 1, size, f);
+  fclose(f);
+
+  // A capture from the board's Serial port may start with boot messages.
+  size_t pos = 0;
+  while (pos + 9 <= size && memcmp(&trace[pos], DWIN_TRACE_MAGIC, 4) != 0) pos++;
+  if (pos + 9 > size || trace[pos + 4] != DWIN_TRACE_VERSION) {
+    fprintf(stderr, "%s: no version %d trace header\n", path, DWIN_TRACE_VERSION);
+    free(trace);
+    return 1;
+  }
+  uint32_t recorded_baud = trace[pos + 5] | trace[pos + 6] << 8 | trace[pos + 7] << 16 | (uint32_t)trace[pos + 8] << 24;
+  if (baud == 0) baud = recorded_baud;
+  pos += 9;
+
+  dwin_emu_init(baud);
+  static uint8_t frame[DWIN_MAX_FRAME_SIZE + 5];
+  uint64_t recorded_us = 0;
+  uint32_t records = 0;
+  uint32_t last_len = 0;
+  bool truncated = false;
+  while (pos < size) {
+    uint32_t dt, len;
+    size_t n = dwin_trace_read_varint(&trace[pos], size - pos, &dt);
+    size_t m = n ? dwin_trace_read_varint(&trace[pos + n], size - pos - n, &len) : 0;
+    if (!n || !m || len > DWIN_MAX_FRAME_SIZE || pos + n + m + len > size) {
+      truncated = true;
+      break;
+    }
+    pos += n + m;
+    frame[0] = FRAME_HEADER;
+    memcpy(&frame[1], &trace[pos], len);
+    memcpy(&frame[1 + len], FRAME_TAIL, sizeof(FRAME_TAIL));
+    dwin_emu_feed(frame, len + 5);
+    pos += len;
+    recorded_us += dt;
+    records++;
+    last_len = len + 5;
+  }
+  free(trace);
+  // Time stamps are taken when a frame is queued; the session ends once the last one is sent.
+  if (records) recorded_us += dwin_emu_wire_us(last_len);
+
+  const dwin_emu_stats_t *stats = dwin_emu_get_stats();
+  uint64_t wire_us = dwin_emu_wire_us(stats->bytes);
+  printf("replay %s @ %u baud (recorded at %u)%s\n", path, baud, recorded_baud, truncated ? ", truncated" : "");
+  printf("  recorded     %.1f ms, %u frames\n", recorded_us / 1000.0, records);
+  printf("  wire bytes   %llu\n", (unsigned long long)stats->bytes);
+  printf("  frames       %u (bad %u)\n", stats->frames, stats->bad_frames);
+  for (int cmd = 0; cmd < 256; cmd++) {
+    if (stats->cmd_frames[cmd]) printf("    cmd 0x%02X   %u\n", cmd, stats->cmd_frames[cmd]);
+  }
+  printf("  wire time    %.1f ms\n", wire_us / 1000.0);
+  // Frames queued faster than the UART sends them push the ratio past 100%.
+  if (recorded_us) {
+    printf("  throughput   %.1f kB/s, wire time %.1f%% of the recorded time\n",
+           stats->bytes * 1000.0 / recorded_us, 100.0 * wire_us / recorded_us);
+  }
+
+  if (ppm_path && !dwin_emu_save_ppm(ppm_path)) {
+    fprintf(stderr, "cannot write %s\n", ppm_path);
+  }
+  return 0;
+}
+
+//==============================================================================
+// MAIN
+//==============================================================================
+
+int main(int argc, char **argv) {
+  const char *screen_name = "hmi";
+  const char *ppm_path = NULL;
+  const char *record_path = NULL;
+  const char *replay_path = NULL;
+  uint32_t baud = 115200;
+  uint32_t replay_baud = 0;   // --replay uses the recorded rate unless --baud is given
+  uint32_t run_ms = 2000;
+  long shadow_budget = -1;
+  dwin_encoding_t encoding = DWIN_ENC_AUTO;
+  dwin_quant_mode_t quant_mode = DWIN_QUANT_LOSSLESS;
+  uint8_t quant_level = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--screen") && i + 1 < argc) screen_name = argv[++i];
+    else if (!strcmp(argv[i], "--baud") && i + 1 < argc) baud = replay_baud = strtoul(argv[++i], NULL, 10);
+    else if (!strcmp(argv[i], "--ms") && i + 1 < argc) run_ms = strtoul(argv[++i], NULL, 10);
+    else if (!strcmp(argv[i], "--ppm") && i + 1 < argc) ppm_path = argv[++i];
+    else if (!strcmp(argv[i], "--record") && i + 1 < argc) record_path = argv[++i];
+    else if (!strcmp(argv[i], "--replay") && i + 1 < argc) replay_path = argv[++i];
+    else if (!strcmp(argv[i], "--shadow") && i + 1 < argc) shadow_budget = strtol(argv[++i], NULL, 10);
+    else if (!strcmp(argv[i], "--encoder") && i + 1 < argc) {
+      const char *name = argv[++i];
+      for (int e = 0; e < DWIN_ENC_COUNT; e++) {
+        if (!strcmp(name, dwin_encoding_name((dwin_encoding_t)e))) encoding = (dwin_encoding_t)e;
+      }
+    }
+    else if (!strcmp(argv[i], "--quantize") && i + 2 < argc) {
+      const char *mode = argv[++i];
+      quant_mode = !strcmp(mode, "palette") ? DWIN_QUANT_PALETTE :
+                   !strcmp(mode, "tolerance") ? DWIN_QUANT_TOLERANCE : DWIN_QUANT_LOSSLESS;
+      quant_level = strtoul(argv[++i], NULL, 10);
+    }
+    else if (!strcmp(argv[i], "--quiet")) quiet = true;
+    else if (!strcmp(argv[i], "--kernel")) {
+      kernel_bench();
+      return 0;
+    }
+    else if (!strcmp(argv[i], "--dgus")) return dgus_check();
+    else {
+      fprintf(stderr, "usage: %s [--screen hmi|status|menu|scroll|icons|tiles|picture|gradient|bitmap] [--baud N] [--ms N] [--shadow BYTES] [--encoder NAME] [--quantize palette|tolerance LEVEL] [--quiet] [--ppm file] [--record trace] | --replay trace [--baud N] [--ppm file] | --kernel | --dgus\n", argv[0]);
+      return 2;
+    }
+  }
+  if (replay_path) return replay_trace(replay_path, replay_baud, ppm_path);
+
+  const bench_screen_t *screen = NULL;
+  for (size_t i = 0; i < sizeof(screens) / sizeof(screens[0]); i++) {
+    if (!strcmp(screens[i].name, screen_name)) screen = &screens[i];
+  }
+  if (!screen) {
+    fprintf(stderr, "unknown screen '%s'\n", screen_name);
+    return 2;
+  }
+
+  dwin_emu_init(baud);
+  DWINSerial.begin(baud);
+  lvgl_driver_init();
+
+  if (shadow_budget >= 0) dwin_shadow_init(shadow_budget);
+
+  dwin_encoder_force(encoding);
+  dwin_quantize_set(quant_mode, quant_level);
+
+  // Setup messages are not part of the measurement
+  dwin_emu_init(baud);
+  dwin_encoder_reset_stats();
+  dwin_telemetry_reset();
+  memset(reference, 0, sizeof(reference));
+
+  FILE *record = NULL;
+  if (record_path) {
+    record = fopen(record_path, "wb");
+    if (!record) {
+      fprintf(stderr, "cannot write %s\n", record_path);
+      return 2;
+    }
+    dwin_trace_start(bench_trace_sink, record, baud);
+  }
+
+  lv_disp_t *disp = lv_disp_get_default();
+  driver_flush_cb = disp->driver->flush_cb;
+  disp->driver->flush_cb = bench_flush;
+
+  screen->create();
+
+  unsigned long start = millis();
+  unsigned long last_tick = start;
+  while (millis() - start < run_ms) {
+    unsigned long now = millis();
+    lv_tick_inc(now - last_tick);
+    last_tick = now;
+    if (screen->step) screen->step(now - start);
+    lv_timer_handler();
+    delay(5);
+  }
+
+  const dwin_emu_stats_t *stats = dwin_emu_get_stats();
+  uint32_t total_mismatches = 0;
+  for (int32_t i = 0; i < DWIN_WIDTH * DWIN_HEIGHT; i++) {
+    if (bench_skip_pixel(dwin_emu_native_mask()[i])) continue;
+    if (bench_pixel_differs(dwin_emu_framebuffer()[i], reference[i])) total_mismatches++;
+  }
+
+  printf("\nscreen %s @ %u baud, %u ms of LVGL time\n", screen->name, baud, run_ms);
+  printf("  flushes      %u (%llu px)\n", flush_count, (unsigned long long)flush_pixels);
+  printf("  wire bytes   %llu (%.2f B/px)\n", (unsigned long long)stats->bytes,
+         flush_pixels ? (double)stats->bytes / flush_pixels : 0.0);
+  printf("  frames       %u (bad %u)\n", stats->frames, stats->bad_frames);
+  for (int cmd = 0; cmd < 256; cmd++) {
+    if (stats->cmd_frames[cmd]) printf("    cmd 0x%02X   %u\n", cmd, stats->cmd_frames[cmd]);
+  }
+  printf("  wire time    %.1f ms\n", dwin_emu_wire_us(stats->bytes) / 1000.0);
+
+  dwin_tx_stats_t tx;
+  dwin_tx_get_stats(&tx);
+  printf("  driver       %u frames in %u writes, %u dropped (over %d B)\n",
+         tx.frames, tx.writes, tx.dropped, DWIN_MAX_FRAME_SIZE);
+  dwin_rx_stats_t rx;
+  dwin_rx_get_stats(&rx);
+  printf("  flow control %u sync points, %u answered, %u writes held back (%.1f ms), %u timeouts\n",
+         rx.syncs, rx.acks, rx.waits, rx.wait_us / 1000.0, rx.timeouts);
+
+  // The host flushes inline, so overlap stays at zero here; on the ESP32 it
+  // shows how much rendering the flush task hid behind transmission.
+  dwin_pipeline_stats_t pipe;
+  dwin_pipeline_get_stats(&pipe);
+  printf("  pipeline     %u flushes, busy %.1f ms, waited %.1f ms, overlap %.1f ms\n",
+         pipe.flushes, pipe.busy_us / 1000.0, pipe.wait_us / 1000.0, pipe.overlap_us / 1000.0);
+
+  const dwin_encoder_stats_t *enc = dwin_encoder_get_stats();
+  printf("  encoder      %s, %u areas (%u split into tiles)\n", dwin_encoding_name(encoding), enc->areas, enc->tiled_areas);
+  if (quant_mode != DWIN_QUANT_LOSSLESS) {
+    printf("  quantize     %s %u, %u px changed, max error %u\n", quant_mode == DWIN_QUANT_PALETTE ? "palette" : "tolerance",
+           quant_level, enc->quantized_px, dwin_quantize_max_error());
+  }
+  for (int e = 0; e < DWIN_ENC_COUNT; e++) {
+    if (enc->blocks[e]) {
+      printf("    %-8s   %u blocks, %u px, ~%u B\n", dwin_encoding_name((dwin_encoding_t)e),
+             enc->blocks[e], enc->pixels[e], enc->est_bytes[e]);
+    }
+  }
+  printf("  scrolling    %u moves\n", dwin_scroll_moves());
+
+  const dwin_draw_stats_t *draw = dwin_draw_get_stats();
+  printf("  native       %u strings, %u glyphs, %u glyphs rasterized, %u sprites dropped\n",
+         draw->strings, draw->glyphs, draw->fallback, draw->dropped);
+  printf("  primitives   %u rects, %u lines, %u px already drawn\n", draw->rects, draw->lines, draw->skipped_px);
+  const dwin_atlas_stats_t *atlas = dwin_atlas_get_stats();
+  printf("  atlas        %u pictures loaded (%u replaced), %u sprites (%u px) drawn from VRAM\n",
+         atlas->loads, atlas->evictions, atlas->draws, atlas->draw_px);
+  const dwin_tile_stats_t *tiles = dwin_tiles_get_stats();
+  printf("  tile cache   %u/%d tiles, %u evicted, %u/%u hits (%.1f%%), %u copies (%u px)\n",
+         tiles->entries, DWIN_TILE_CACHE_ENTRIES, tiles->evictions, tiles->hits, tiles->lookups,
+         tiles->lookups ? 100.0 * tiles->hits / tiles->lookups : 0.0, tiles->copies, tiles->copied_px);
+  if (record) {
+    dwin_trace_stop();
+    fclose(record);
+    const dwin_trace_stats_t *trace = dwin_trace_get_stats();
+    printf("  trace        %u frames, %u B for %u wire bytes, in %s\n",
+           trace->frames, trace->trace_bytes, trace->frame_bytes, record_path);
+  }
+
+  // Encode times are host CPU time; transmit times only cover the emulator
+  // parsing the frames, the wire time is above.
+  printf("  telemetry\n");
+  dwin_telemetry_report();
+  printf("  pixel check  %s (%u flushes, %u px differ)\n",
+         total_mismatches || mismatched_flushes ? "FAIL" : "ok", mismatched_flushes, total_mismatches);
+
+  if (ppm_path && !dwin_emu_save_ppm(ppm_path)) {
+    fprintf(stderr, "cannot write %s\n", ppm_path);
+  }
+  return total_mismatches || mismatched_flushes ? 1 : 0;
+}
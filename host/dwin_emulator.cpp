@@ -0,0 +1,376 @@
+/**
+ * @file dwin_emulator.cpp
+ * @brief T5UIC1 frame parser and RGB565 rasterizer for the host build.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include <deque>
+#include <map>
+
+#include "dwin_emulator.h"
+
+// Frames longer than this are treated as garbage (the panel's receive buffer is far smaller).
+#define DWIN_EMU_MAX_FRAME 65536
+
+static uint16_t framebuffer[DWIN_WIDTH * DWIN_HEIGHT];
+static uint16_t vram[DWIN_EMU_VRAM_PAGES][DWIN_WIDTH * DWIN_HEIGHT];
+static uint8_t native_mask[DWIN_WIDTH * DWIN_HEIGHT];
+static std::map<uint8_t, std::vector<uint16_t> > flash_pictures;
+
+static dwin_emu_stats_t stats;
+static uint32_t emu_baud = 115200;
+
+static std::vector<uint8_t> frame;   // Bytes after FRAME_HEADER, including the tail
+static bool in_frame = false;
+static std::deque<uint8_t> response;
+
+// Glyph cell sizes for FONT_6x12 .. FONT_32x64
+static const uint8_t font_width[10] = {6, 8, 10, 12, 14, 16, 20, 24, 28, 32};
+
+//==============================================================================
+// RASTER HELPERS
+//==============================================================================
+
+static inline void put_pixel(int32_t x, int32_t y, uint16_t color) {
+  if (x < 0 || y < 0 || x >= DWIN_WIDTH || y >= DWIN_HEIGHT) return;
+  framebuffer[y * DWIN_WIDTH + x] = color;
+}
+
+static void fill_rect(int32_t xs, int32_t ys, int32_t xe, int32_t ye, uint16_t color, bool do_xor) {
+  if (xs > xe || ys > ye) return;
+  if (xs < 0) xs = 0;
+  if (ys < 0) ys = 0;
+  if (xe >= DWIN_WIDTH) xe = DWIN_WIDTH - 1;
+  if (ye >= DWIN_HEIGHT) ye = DWIN_HEIGHT - 1;
+  for (int32_t y = ys; y <= ye; y++) {
+    uint16_t* row = &framebuffer[y * DWIN_WIDTH];
+    for (int32_t x = xs; x <= xe; x++) {
+      row[x] = do_xor ? (uint16_t)(row[x] ^ color) : color;
+    }
+  }
+}
+
+static void draw_line(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color) {
+  int32_t dx = x1 > x0 ? x1 - x0 : x0 - x1;
+  int32_t dy = y1 > y0 ? y0 - y1 : y1 - y0;
+  int32_t sx = x0 < x1 ? 1 : -1;
+  int32_t sy = y0 < y1 ? 1 : -1;
+  int32_t err = dx + dy;
+  while (true) {
+    put_pixel(x0, y0, color);
+    if (x0 == x1 && y0 == y1) break;
+    int32_t e2 = 2 * err;
+    if (e2 >= dy) { err += dy; x0 += sx; }
+    if (e2 <= dx) { err += dx; y0 += sy; }
+  }
+}
+
+//==============================================================================
+// COMMAND HANDLERS
+//==============================================================================
+
+static inline uint16_t rd_word(const uint8_t* p) {
+  return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void cmd_set_point(const uint8_t* p, size_t n) {
+  if (n < 4) { stats.bad_frames++; return; }
+  uint16_t color = rd_word(p);
+  uint8_t nx = p[2] ? p[2] : 1;
+  uint8_t ny = p[3] ? p[3] : 1;
+  for (size_t i = 4; i + 4 <= n; i += 4) {
+    int32_t x = rd_word(p + i);
+    int32_t y = rd_word(p + i + 2);
+    fill_rect(x, y, x + nx - 1, y + ny - 1, color, false);
+  }
+}
+
+static void cmd_draw_line(const uint8_t* p, size_t n) {
+  if (n < 6) { stats.bad_frames++; return; }
+  uint16_t color = rd_word(p);
+  int32_t px = rd_word(p + 2);
+  int32_t py = rd_word(p + 4);
+  put_pixel(px, py, color);
+  for (size_t i = 6; i + 4 <= n; i += 4) {
+    int32_t x = rd_word(p + i);
+    int32_t y = rd_word(p + i + 2);
+    draw_line(px, py, x, y, color);
+    px = x;
+    py = y;
+  }
+}
+
+static void cmd_draw_rect(const uint8_t* p, size_t n) {
+  if (n < 11) { stats.bad_frames++; return; }
+  uint8_t mode = p[0];
+  uint16_t color = rd_word(p + 1);
+  int32_t xs = rd_word(p + 3), ys = rd_word(p + 5);
+  int32_t xe = rd_word(p + 7), ye = rd_word(p + 9);
+  switch (mode) {
+    case 0x00:
+      fill_rect(xs, ys, xe, ys, color, false);
+      fill_rect(xs, ye, xe, ye, color, false);
+      fill_rect(xs, ys, xs, ye, color, false);
+      fill_rect(xe, ys, xe, ye, color, false);
+      break;
+    case 0x01: fill_rect(xs, ys, xe, ye, color, false); break;
+    case 0x02: fill_rect(xs, ys, xe, ye, color, true); break;
+    default: stats.bad_frames++; break;
+  }
+}
+
+// AA 08 [X] [Y] [Wide] [Color1] [Color0] [data]: rows of ceil(Wide/8) bytes, MSB is the leftmost pixel.
+static void cmd_draw_bitmap(const uint8_t* p, size_t n) {
+  if (n < 10) { stats.bad_frames++; return; }
+  int32_t x0 = rd_word(p), y0 = rd_word(p + 2);
+  int32_t wide = rd_word(p + 4);
+  uint16_t color1 = rd_word(p + 6), color0 = rd_word(p + 8);
+  const uint8_t* data = p + 10;
+  size_t len = n - 10;
+  size_t stride = (wide + 7) / 8;
+  if (stride == 0) return;
+  for (size_t row = 0; row * stride < len; row++) {
+    for (int32_t x = 0; x < wide && row * stride + x / 8 < len; x++) {
+      bool bit = data[row * stride + x / 8] & (0x80 >> (x & 7));
+      put_pixel(x0 + x, y0 + (int32_t)row, bit ? color1 : color0);
+    }
+  }
+}
+
+// AA 09 [mode<<7 | dir] [dis] [color] [Xs] [Ys] [Xe] [Ye]; dir 0=left 1=right 2=up 3=down.
+static void cmd_move_area(const uint8_t* p, size_t n) {
+  if (n < 13) { stats.bad_frames++; return; }
+  bool translate = p[0] & 0x80;
+  uint8_t dir = p[0] & 0x0F;
+  int32_t dis = rd_word(p + 1);
+  uint16_t color = rd_word(p + 3);
+  int32_t xs = rd_word(p + 5), ys = rd_word(p + 7);
+  int32_t xe = rd_word(p + 9), ye = rd_word(p + 11);
+  if (xe >= DWIN_WIDTH) xe = DWIN_WIDTH - 1;
+  if (ye >= DWIN_HEIGHT) ye = DWIN_HEIGHT - 1;
+  if (xs > xe || ys > ye || dir > 3) { stats.bad_frames++; return; }
+
+  int32_t w = xe - xs + 1, h = ye - ys + 1;
+  std::vector<uint16_t> src(w * h);
+  for (int32_t y = 0; y < h; y++) {
+    memcpy(&src[y * w], &framebuffer[(ys + y) * DWIN_WIDTH + xs], w * sizeof(uint16_t));
+  }
+  int32_t dx = dir == 0 ? -dis : (dir == 1 ? dis : 0);
+  int32_t dy = dir == 2 ? -dis : (dir == 3 ? dis : 0);
+  for (int32_t y = 0; y < h; y++) {
+    for (int32_t x = 0; x < w; x++) {
+      int32_t sx = x - dx, sy = y - dy;
+      uint16_t c;
+      if (sx >= 0 && sx < w && sy >= 0 && sy < h) {
+        c = src[sy * w + sx];
+      } else if (translate) {
+        c = color;
+      } else {
+        c = src[((sy % h + h) % h) * w + ((sx % w + w) % w)];
+      }
+      framebuffer[(ys + y) * DWIN_WIDTH + xs + x] = c;
+    }
+  }
+
+  // Glyphs drawn by the panel move with the pixels.
+  std::vector<uint8_t> mask(w * h);
+  for (int32_t y = 0; y < h; y++) {
+    memcpy(&mask[y * w], &native_mask[(ys + y) * DWIN_WIDTH + xs], w);
+  }
+  for (int32_t y = 0; y < h; y++) {
+    for (int32_t x = 0; x < w; x++) {
+      int32_t sx = x - dx, sy = y - dy;
+      bool inside = sx >= 0 && sx < w && sy >= 0 && sy < h;
+      native_mask[(ys + y) * DWIN_WIDTH + xs + x] = inside ? mask[sy * w + sx] : 0;
+    }
+  }
+}
+
+// The emulator has no font ROM: each glyph is drawn as a solid block inside its cell.
+static void cmd_draw_string(const uint8_t* p, size_t n) {
+  if (n < 9) { stats.bad_frames++; return; }
+  uint8_t mode = p[0];
+  uint8_t size = mode & 0x0F;
+  bool show_bg = mode & 0x40;
+  uint16_t color = rd_word(p + 1), bcolor = rd_word(p + 3);
+  int32_t x = rd_word(p + 5), y = rd_word(p + 7);
+  if (size > 9) { stats.bad_frames++; return; }
+  int32_t cw = font_width[size], ch = cw * 2;
+  for (size_t i = 9; i < n; i++, x += cw) {
+    if (show_bg) fill_rect(x, y, x + cw - 1, y + ch - 1, bcolor, false);
+    if (p[i] != ' ') fill_rect(x + 1, y + ch / 4, x + cw - 2, y + ch - ch / 4 - 1, color, false);
+    for (int32_t gy = std::max(y, (int32_t)0); gy < std::min(y + ch, (int32_t)DWIN_HEIGHT); gy++) {
+      for (int32_t gx = std::max(x, (int32_t)0); gx < std::min(x + cw, (int32_t)DWIN_WIDTH); gx++) {
+        native_mask[gy * DWIN_WIDTH + gx] = DWIN_EMU_MASK_GLYPH;
+      }
+    }
+  }
+}
+
+// AA 27 [mode] [Xs] [Ys] [Xe] [Ye] [X] [Y]: copies from VRAM page (mode & 0x0F) to the screen.
+static void cmd_virt_copy_paste(const uint8_t* p, size_t n) {
+  if (n < 13) { stats.bad_frames++; return; }
+  uint8_t page = p[0] & 0x0F;
+  int32_t xs = rd_word(p + 1), ys = rd_word(p + 3);
+  int32_t xe = rd_word(p + 5), ye = rd_word(p + 7);
+  int32_t x = rd_word(p + 9), y = rd_word(p + 11);
+  if (page >= DWIN_EMU_VRAM_PAGES || xe >= DWIN_WIDTH || ye >= DWIN_HEIGHT || xs > xe || ys > ye) {
+    stats.bad_frames++;
+    return;
+  }
+  for (int32_t sy = ys; sy <= ye; sy++) {
+    for (int32_t sx = xs; sx <= xe; sx++) {
+      int32_t dx = x + sx - xs, dy = y + sy - ys;
+      put_pixel(dx, dy, vram[page][sy * DWIN_WIDTH + sx]);
+      if (dx < DWIN_WIDTH && dy < DWIN_HEIGHT) native_mask[dy * DWIN_WIDTH + dx] = DWIN_EMU_MASK_COPY;
+    }
+  }
+}
+
+// AA 25 [page] [id]: decodes picture id from the panel flash into a VRAM page.
+static void cmd_decompress_jpeg(const uint8_t* p, size_t n) {
+  if (n < 2) { stats.bad_frames++; return; }
+  uint8_t page = p[0], id = p[1];
+  auto picture = flash_pictures.find(id);
+  if (page >= DWIN_EMU_VRAM_PAGES || picture == flash_pictures.end()) {
+    stats.bad_frames++;
+    return;
+  }
+  memcpy(vram[page], picture->second.data(), sizeof(vram[page]));
+}
+
+static void dispatch_frame(const uint8_t* p, size_t n) {
+  uint8_t cmd = p[0];
+  stats.frames++;
+  stats.cmd_frames[cmd]++;
+  p++;
+  n--;
+
+  if (cmd == CMD_HANDSHAKE) {
+    static const uint8_t ok[] = {0xAA, 0x00, 'O', 'K', 0xCC, 0x33, 0xC3, 0x3C};
+    response.insert(response.end(), ok, ok + sizeof(ok));
+  } else if (cmd == CMD_CLEAR_SCREEN) {
+    if (n < 2) { stats.bad_frames++; return; }
+    fill_rect(0, 0, DWIN_WIDTH - 1, DWIN_HEIGHT - 1, rd_word(p), false);
+  } else if (cmd == CMD_SET_POINT) {
+    cmd_set_point(p, n);
+  } else if (cmd == CMD_DRAW_LINE) {
+    cmd_draw_line(p, n);
+  } else if (cmd == CMD_DRAW_RECT) {
+    cmd_draw_rect(p, n);
+  } else if (cmd == CMD_DRAW_BITMAP) {
+    cmd_draw_bitmap(p, n);
+  } else if (cmd == CMD_MOVE_AREA) {
+    cmd_move_area(p, n);
+  } else if (cmd == CMD_DRAW_STRING) {
+    cmd_draw_string(p, n);
+  } else if (cmd == CMD_VIRT_COPY_PASTE) {
+    cmd_virt_copy_paste(p, n);
+  } else if (cmd == CMD_DECOMPRESS_JPEG) {
+    cmd_decompress_jpeg(p, n);
+  }
+  // CMD_BACKLIGHT, CMD_SET_DIRECTION and CMD_UPDATE_LCD do not change the framebuffer.
+}
+
+//==============================================================================
+// PUBLIC API
+//==============================================================================
+
+void dwin_emu_init(uint32_t baud) {
+  emu_baud = baud;
+  memset(framebuffer, 0, sizeof(framebuffer));
+  memset(vram, 0, sizeof(vram));
+  memset(native_mask, 0, sizeof(native_mask));
+  memset(&stats, 0, sizeof(stats));
+  frame.clear();
+  in_frame = false;
+  response.clear();
+}
+
+void dwin_emu_feed(const uint8_t* data, size_t len) {
+  stats.bytes += len;
+  for (size_t i = 0; i < len; i++) {
+    uint8_t b = data[i];
+    if (!in_frame) {
+      if (b == FRAME_HEADER) {
+        in_frame = true;
+        frame.clear();
+      }
+      continue;
+    }
+    frame.push_back(b);
+    size_t n = frame.size();
+    if (n >= 5 && memcmp(&frame[n - 4], FRAME_TAIL, 4) == 0) {
+      dispatch_frame(frame.data(), n - 4);
+      in_frame = false;
+    } else if (n > DWIN_EMU_MAX_FRAME) {
+      stats.bad_frames++;
+      in_frame = false;
+    }
+  }
+}
+
+int dwin_emu_read() {
+  if (response.empty()) return -1;
+  uint8_t b = response.front();
+  response.pop_front();
+  return b;
+}
+
+int dwin_emu_available() {
+  return (int)response.size();
+}
+
+const dwin_emu_stats_t* dwin_emu_get_stats() {
+  return &stats;
+}
+
+uint32_t dwin_emu_get_baud() {
+  return emu_baud;
+}
+
+uint64_t dwin_emu_wire_us(uint64_t bytes) {
+  // 8N1: one start bit, eight data bits, one stop bit per byte
+  return bytes * 10ULL * 1000000ULL / emu_baud;
+}
+
+const uint16_t* dwin_emu_framebuffer() {
+  return framebuffer;
+}
+
+uint16_t dwin_emu_get_pixel(uint16_t x, uint16_t y) {
+  if (x >= DWIN_WIDTH || y >= DWIN_HEIGHT) return 0;
+  return framebuffer[y * DWIN_WIDTH + x];
+}
+
+uint8_t* dwin_emu_native_mask() {
+  return native_mask;
+}
+
+void dwin_emu_flash_picture(uint8_t id, const uint16_t* px) {
+  flash_pictures[id].assign(px, px + DWIN_WIDTH * DWIN_HEIGHT);
+}
+
+uint16_t* dwin_emu_vram(uint8_t page) {
+  return page < DWIN_EMU_VRAM_PAGES ? vram[page] : NULL;
+}
+
+bool dwin_emu_save_ppm(const char* path) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+  fprintf(f, "P6\n%d %d\n255\n", DWIN_WIDTH, DWIN_HEIGHT);
+  for (int32_t i = 0; i < DWIN_WIDTH * DWIN_HEIGHT; i++) {
+    uint16_t c = framebuffer[i];
+    uint8_t rgb[3] = {
+      (uint8_t)(((c >> 11) & 0x1F) * 255 / 31),
+      (uint8_t)(((c >> 5) & 0x3F) * 255 / 63),
+      (uint8_t)((c & 0x1F) * 255 / 31),
+    };
+    fwrite(rgb, 1, 3, f);
+  }
+  fclose(f);
+  return true;
+}
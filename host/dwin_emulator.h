@@ -0,0 +1,98 @@
+/**
+ * @file dwin_emulator.h
+ * @brief Host-side emulator of the DWIN T5UIC1 serial protocol.
+ *
+ * @details Bytes written to the emulated UART are split into
+ * `AA ... CC 33 C3 3C` frames and rendered into an RGB565 framebuffer of
+ * DWIN_WIDTH x DWIN_HEIGHT pixels (the 90-degree orientation used by the
+ * LVGL driver). Every byte and frame is counted so encoder changes can be
+ * measured without the real panel.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <dwin.h>
+
+// Number of emulated virtual display areas (VRAM pages) used by CMD_VIRT_COPY_PASTE.
+#define DWIN_EMU_VRAM_PAGES 2
+
+typedef struct {
+  uint64_t bytes;              // Bytes received on the wire
+  uint32_t frames;             // Complete frames parsed
+  uint32_t bad_frames;         // Frames dropped (oversized or malformed)
+  uint32_t cmd_frames[256];    // Frames per command code
+} dwin_emu_stats_t;
+
+/**
+ * @brief Resets the framebuffer, VRAM pages and counters.
+ * @param baud Simulated UART baud rate, used for transfer time estimates.
+ */
+void dwin_emu_init(uint32_t baud);
+
+/**
+ * @brief Feeds bytes written by the driver into the frame parser.
+ * @param data Bytes as they would leave the ESP32 TX pin.
+ * @param len Number of bytes.
+ */
+void dwin_emu_feed(const uint8_t* data, size_t len);
+
+/**
+ * @brief Pops one byte of panel response (handshake etc.).
+ * @return The byte, or -1 if nothing is pending.
+ */
+int dwin_emu_read();
+
+/**
+ * @brief Number of response bytes waiting to be read.
+ */
+int dwin_emu_available();
+
+const dwin_emu_stats_t* dwin_emu_get_stats();
+uint32_t dwin_emu_get_baud();
+
+/**
+ * @brief Simulated time needed to transfer a number of bytes (8N1 framing).
+ * @param bytes Number of bytes on the wire.
+ * @return Transfer time in microseconds.
+ */
+uint64_t dwin_emu_wire_us(uint64_t bytes);
+
+/**
+ * @brief Returns the emulated panel contents (row-major, DWIN_WIDTH stride).
+ */
+const uint16_t* dwin_emu_framebuffer();
+uint16_t dwin_emu_get_pixel(uint16_t x, uint16_t y);
+
+// Values of dwin_emu_native_mask()
+#define DWIN_EMU_MASK_GLYPH 1
+#define DWIN_EMU_MASK_COPY 2
+
+/**
+ * @brief Marks the pixels the panel drew from its own memory (font ROM glyph
+ * cells, VRAM copies) since the caller last cleared them.
+ * @return Pointer to DWIN_WIDTH x DWIN_HEIGHT DWIN_EMU_MASK_* values, 0 where
+ * the pixel came over the wire.
+ */
+uint8_t* dwin_emu_native_mask();
+
+/**
+ * @brief Stores a picture in the emulated panel flash, for CMD_DECOMPRESS_JPEG.
+ * @param id Picture number.
+ * @param px DWIN_WIDTH x DWIN_HEIGHT RGB565 pixels (copied).
+ */
+void dwin_emu_flash_picture(uint8_t id, const uint16_t* px);
+
+/**
+ * @brief Gives direct access to a virtual display area so the bench can preload it.
+ * @param page VRAM page number (0 .. DWIN_EMU_VRAM_PAGES-1).
+ * @return Pointer to DWIN_WIDTH x DWIN_HEIGHT pixels, or NULL for an invalid page.
+ */
+uint16_t* dwin_emu_vram(uint8_t page);
+
+/**
+ * @brief Writes the framebuffer as a binary PPM image.
+ * @param path Output file path.
+ * @return true on success.
+ */
+bool dwin_emu_save_ppm(const char* path);
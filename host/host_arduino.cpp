@@ -0,0 +1,151 @@
+/**
+ * @file host_arduino.cpp
+ * @brief Virtual clock, serial ports and SPI bus backing the host Arduino stand-in.
+ */
+
+#include <stdarg.h>
+#include <Arduino.h>
+#include <SPI.h>
+#include "dwin_emulator.h"
+#include "dgus_emulator.h"
+
+HardwareSerial Serial(0);
+SPIClass SPI;
+
+static uint64_t now_us = 0;
+static uint64_t dead_us = 0;
+
+//==============================================================================
+// TIME
+//==============================================================================
+
+void delay(uint32_t ms) {
+  now_us += (uint64_t)ms * 1000;
+  dead_us += (uint64_t)ms * 1000;
+}
+
+void delayMicroseconds(uint32_t us) {
+  now_us += us;
+  dead_us += us;
+}
+
+unsigned long millis() {
+  return (unsigned long)(now_us / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)now_us;
+}
+
+void host_advance_us(uint64_t us) {
+  now_us += us;
+}
+
+uint64_t host_delay_us() {
+  return dead_us;
+}
+
+//==============================================================================
+// GPIO
+//==============================================================================
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+void digitalWrite(uint8_t pin, uint8_t value) {}
+
+//==============================================================================
+// HARDWARE TIMER
+//==============================================================================
+
+hw_timer_t *timerBegin(uint8_t num, uint16_t divider, bool countUp) {
+  return NULL;
+}
+
+void timerAttachInterrupt(hw_timer_t *timer, void (*fn)(void), bool edge) {}
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarm_value, bool autoreload) {}
+void timerAlarmEnable(hw_timer_t *timer) {}
+
+//==============================================================================
+// SERIAL PORTS
+//==============================================================================
+
+HardwareSerial::HardwareSerial(int uart_nr) : uartNr(uart_nr), baud(115200) {}
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rxPin, int8_t txPin) {
+  this->baud = baud;
+}
+
+size_t HardwareSerial::write(uint8_t value) {
+  return write(&value, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  if (uartNr == 0) {
+    return fwrite(buffer, 1, size, stdout);
+  }
+  // Writes block for as long as the bytes take on the wire.
+  dwin_emu_feed(buffer, size);
+  host_advance_us(dwin_emu_wire_us(size));
+  return size;
+}
+
+int HardwareSerial::available() {
+  return uartNr == 0 ? 0 : dwin_emu_available();
+}
+
+int HardwareSerial::availableForWrite() {
+  return 128;
+}
+
+int HardwareSerial::read() {
+  return uartNr == 0 ? -1 : dwin_emu_read();
+}
+
+int HardwareSerial::peek() {
+  return -1;
+}
+
+void HardwareSerial::flush() {
+  if (uartNr == 0) fflush(stdout);
+}
+
+size_t HardwareSerial::print(const char *str) {
+  return write((const uint8_t *)str, strlen(str));
+}
+
+size_t HardwareSerial::print(long value) {
+  return printf("%ld", value);
+}
+
+size_t HardwareSerial::println(const char *str) {
+  return print(str) + print("\n");
+}
+
+size_t HardwareSerial::println(long value) {
+  return print(value) + print("\n");
+}
+
+size_t HardwareSerial::printf(const char *format, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (len < 0) return 0;
+  if ((size_t)len >= sizeof(buf)) len = sizeof(buf) - 1;
+  return write((const uint8_t *)buf, len);
+}
+
+//==============================================================================
+// SPI BUS
+//==============================================================================
+
+void SPIClass::begin(int8_t sck, int8_t miso, int8_t mosi, int8_t ss) {}
+void SPIClass::beginTransaction(SPISettings settings) {}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+  return dgus_emu_transfer(data);
+}
+
+void SPIClass::endTransaction() {
+  dgus_emu_end();
+}
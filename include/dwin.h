@@ -15,6 +15,7 @@ extern const uint8_t CMD_DRAW_RECT;
 extern const uint8_t CMD_DRAW_BITMAP;
 extern const uint8_t CMD_MOVE_AREA;
 extern const uint8_t CMD_DRAW_STRING;
+extern const uint8_t CMD_DECOMPRESS_JPEG;
 extern const uint8_t CMD_VIRT_COPY_PASTE;
 extern const uint8_t CMD_BACKLIGHT;
 extern const uint8_t CMD_SET_DIRECTION;
@@ -48,9 +49,16 @@ extern const uint16_t COLOR_BG_BLUE;
 #define DWIN_WIDTH 272
 #define DWIN_HEIGHT 480
 
-// Buffer for commands
-extern uint8_t dwin_cmd_buffer[256];
-extern uint8_t cmd_idx;
+// Largest frame sent to the panel, header and tail included. Bigger frames
+// carry more points, line vertices or bitmap rows per header.
+#ifndef DWIN_MAX_FRAME_SIZE
+#define DWIN_MAX_FRAME_SIZE 1024
+#endif
+
+// Frames are built in this arena and written out together (must hold at least one frame).
+#ifndef DWIN_TX_ARENA_SIZE
+#define DWIN_TX_ARENA_SIZE 2048
+#endif
 
 //==============================================================================
 // DWIN LOW-LEVEL COMMUNICATION FUNCTIONS
@@ -58,17 +66,137 @@ extern uint8_t cmd_idx;
 void dwin_start_frame();
 void dwin_add_byte(uint8_t value);
 void dwin_add_word(uint16_t value);
+void dwin_add_bytes(const uint8_t* data, uint32_t len);
 void dwin_add_string(const char* str);
-void dwin_send_frame();
+uint32_t dwin_frame_space();
+bool dwin_send_frame();
+void dwin_flush_frames();
+void dwin_begin_batch();
+void dwin_end_batch();
+
+//==============================================================================
+// DWIN ASYNCHRONOUS TRANSMIT
+//==============================================================================
+// Size of the transmit ring (power of two). Frames are queued here and drained
+// to DWINSerial by a FreeRTOS task once dwin_tx_begin() has been called.
+#ifndef DWIN_TX_RING_SIZE
+#define DWIN_TX_RING_SIZE 4096
+#endif
+
+typedef struct {
+  uint32_t queued;        // Bytes appended to the ring
+  uint32_t sent;          // Bytes handed to the UART
+  uint32_t high_water;    // Largest ring occupancy seen
+  uint32_t stalls;        // Times a frame had to wait for free ring space
+  uint32_t frames;        // Frames completed
+  uint32_t dropped;       // Frames dropped for exceeding DWIN_MAX_FRAME_SIZE
+  uint32_t writes;        // Arena writes (UART writes or ring appends)
+} dwin_tx_stats_t;
+
+bool dwin_tx_begin();
+bool dwin_tx_async();
+void dwin_tx_when_drained(void (*callback)(void* arg), void* arg);
+void dwin_tx_get_stats(dwin_tx_stats_t* stats);
+
+//==============================================================================
+// DWIN RESPONSES AND FLOW CONTROL
+//==============================================================================
+// The T5UIC1 only answers the handshake (AA 00 'O' 'K' CC 33 C3 3C), and it
+// answers in order, after the commands sent before it. A handshake frame is
+// therefore appended to the outgoing frames every DWIN_SYNC_INTERVAL bytes as
+// a sync point, and its answer tells how far the panel has read. Once the
+// panel has answered, no more than DWIN_TX_WINDOW bytes are sent past the
+// last answered sync point, instead of pacing writes with a fixed delay.
+// Without answers (RX not wired) the fixed delay stays.
+
+// Bytes between sync points; 0 disables flow control.
+#ifndef DWIN_SYNC_INTERVAL
+#define DWIN_SYNC_INTERVAL 1024
+#endif
+
+// Bytes that may be in flight beyond the last answered sync point.
+#ifndef DWIN_TX_WINDOW
+#define DWIN_TX_WINDOW 2048
+#endif
+
+// Wait for an answer after which flow control gives up until the next one.
+#ifndef DWIN_SYNC_TIMEOUT_MS
+#define DWIN_SYNC_TIMEOUT_MS 100
+#endif
+
+// Sync points awaiting an answer (power of two).
+#define DWIN_SYNC_PENDING 8
+
+// Longest response frame accepted, header and tail included.
+#define DWIN_RX_MAX_FRAME 32
+
+typedef struct {
+  uint32_t bytes;         // Bytes received
+  uint32_t frames;        // Response frames parsed
+  uint32_t garbage;       // Bytes outside a frame, or in one too long
+  uint32_t syncs;         // Sync points sent
+  uint32_t acks;          // Handshake answers received
+  uint32_t waits;         // Writes held back by the window
+  uint32_t wait_us;       // Time writes were held back
+  uint32_t timeouts;      // Sync points never answered
+} dwin_rx_stats_t;
+
+void dwin_rx_poll();
+void dwin_rx_set_handler(void (*handler)(const uint8_t* payload, uint8_t len));
+bool dwin_handshake(uint32_t timeout_ms);
+bool dwin_panel_answering();
+void dwin_rx_get_stats(dwin_rx_stats_t* stats);
 
 //==============================================================================
 // DWIN HIGH-LEVEL DRAWING FUNCTIONS
 //==============================================================================
 void dwin_draw_setup_string(uint16_t x, uint16_t y, uint16_t color, const char* text);
 void dwin_clear_screen(uint16_t color);
-uint16_t lvgl_to_dwin_color(lv_color_t lvgl_color);
+void dwin_draw_rect(uint8_t mode, uint16_t color, uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye);
+void dwin_draw_line(uint16_t color, uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye);
+void dwin_draw_point(uint16_t color, uint16_t x, uint16_t y);
+void dwin_move_area(uint8_t mode, uint8_t dir, uint16_t dis, uint16_t color,
+                    uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye);
+void dwin_jpeg_cache(uint8_t page, uint8_t picture_id);
+void dwin_virt_copy_paste(uint8_t page, uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye,
+                          uint16_t x, uint16_t y);
+
+// Set when LVGL renders straight into the panel's RGB565 format, so pixels
+// are compared and sent as they are, without any conversion.
+#ifndef DWIN_COLOR_NATIVE
+#define DWIN_COLOR_NATIVE (LV_COLOR_DEPTH == 16 && !LV_COLOR_16_SWAP)
+#endif
+
+/**
+ * @brief Converts an LVGL color to DWIN's 16-bit RGB565 format.
+ * @param lvgl_color The LVGL color structure.
+ * @return The 16-bit RGB565 color word.
+ * @note Inline, as the encoders convert pixel by pixel. With LV_COLOR_DEPTH 16
+ * the channels are already 5/6/5 bits wide and must not be shifted again;
+ * lv_color_to16() handles every other color depth.
+ */
+static inline uint16_t lvgl_to_dwin_color(lv_color_t lvgl_color) {
+#if DWIN_COLOR_NATIVE
+  return lvgl_color.full;
+#else
+  return lv_color_to16(lvgl_color);
+#endif
+}
 
 //==============================================================================
 // LVGL DRIVER INITIALIZATION
 //==============================================================================
-void lvgl_driver_init();
\ No newline at end of file
+typedef struct {
+  uint32_t flushes;       // Flush callbacks from LVGL
+  uint32_t busy_us;       // Time from hand-over to the bytes leaving the transmit ring
+  uint32_t wait_us;       // Time LVGL spent waiting for a flush to finish
+  uint32_t overlap_us;    // busy_us - wait_us: rendering in parallel with a flush
+} dwin_pipeline_stats_t;
+
+void lvgl_driver_init();
+void dwin_pipeline_get_stats(dwin_pipeline_stats_t* stats);
+bool dwin_shadow_init(size_t budget_bytes);
+void dwin_shadow_invalidate();
+void dwin_shadow_invalidate_area(const lv_area_t* area);
+void dwin_scroll_attach(lv_obj_t* obj);
+uint32_t dwin_scroll_moves();
\ No newline at end of file
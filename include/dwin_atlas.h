@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+#include <lvgl.h>
+#include <dwin.h>
+
+//==============================================================================
+// DWIN SPRITE ATLAS
+//==============================================================================
+// Icons live in a picture stored in the panel's flash (written with the
+// panel's SD card update, like the stock firmware's icon sets). At boot the
+// picture is decoded into a virtual display area (VRAM page) with
+// dwin_atlas_load(), and every sprite registered on it is then drawn with a
+// single CMD_VIRT_COPY_PASTE frame of 19 bytes.
+//
+// Large images (splash screens, print thumbnails) are JPEG pictures in the
+// same flash, registered with dwin_atlas_add_picture(). They are decoded by
+// the panel (CMD_DECOMPRESS_JPEG) into a VRAM page not pinned by
+// dwin_atlas_load() the first time they are drawn, replacing the least
+// recently drawn picture, so showing one costs 27 bytes instead of its pixels.
+
+// Sprites registered since boot; ids of forgotten sprites are not reused.
+#ifndef DWIN_ATLAS_MAX_SPRITES
+#define DWIN_ATLAS_MAX_SPRITES 32
+#endif
+
+// Virtual display areas of the panel.
+#ifndef DWIN_VRAM_PAGES
+#define DWIN_VRAM_PAGES 2
+#endif
+
+// Page of sprites registered with dwin_atlas_add_picture(): decided when drawn.
+#define DWIN_ATLAS_ON_DEMAND 0xFF
+
+typedef struct {
+  const char* name;
+  uint8_t page;           // VRAM page holding the sprite, or DWIN_ATLAS_ON_DEMAND
+  uint8_t picture;        // Picture decoded on demand
+  lv_area_t area;         // Position of the sprite in that page
+  lv_img_dsc_t img;       // LVGL image source drawn as a copy of the area
+} dwin_sprite_t;
+
+typedef struct {
+  uint32_t loads;         // Pictures decoded into VRAM
+  uint32_t evictions;     // On-demand pictures replaced by another one
+  uint32_t draws;         // Copy-paste frames sent for sprites
+  uint32_t draw_px;       // Pixels drawn from VRAM instead of sent
+} dwin_atlas_stats_t;
+
+void dwin_atlas_init();
+bool dwin_atlas_load(uint8_t page, uint8_t picture_id);
+int dwin_atlas_add(uint8_t page, const char* name, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+int dwin_atlas_add_picture(uint8_t picture_id, const char* name, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+int dwin_atlas_find(const char* name);
+const dwin_sprite_t* dwin_atlas_get(int sprite);
+const void* dwin_atlas_img_src(int sprite);
+const dwin_sprite_t* dwin_atlas_from_src(const void* src);
+bool dwin_atlas_draw(int sprite, uint16_t x, uint16_t y);
+bool dwin_atlas_show_picture(uint8_t picture_id);
+bool dwin_atlas_blit(const dwin_sprite_t* sprite, const lv_area_t* part, uint16_t x, uint16_t y);
+const dwin_atlas_stats_t* dwin_atlas_get_stats();
@@ -0,0 +1,68 @@
+#pragma once
+#include <stdint.h>
+#include <lvgl.h>
+#include <dwin.h>
+
+//==============================================================================
+// DWIN NATIVE DRAWING
+//==============================================================================
+// A software draw context whose hooks send some LVGL primitives as DWIN
+// commands instead of rasterizing them into the draw buffer. The commands are
+// queued per draw buffer: fills, frames and lines go out before the buffer's
+// pixels, which are then only sent where they differ from what the panel drew;
+// strings and sprites go out after the pixels, on top of the background LVGL
+// rendered.
+
+// Fills, frames and lines queued per draw buffer. They are also rasterized, so
+// a full queue only means more pixels are sent.
+#ifndef DWIN_NATIVE_OPS_MAX
+#define DWIN_NATIVE_OPS_MAX 32
+#endif
+
+// Native strings and sprite copies queued per draw buffer, and the characters
+// the strings can hold.
+#ifndef DWIN_NATIVE_TEXT_MAX
+#define DWIN_NATIVE_TEXT_MAX 32
+#endif
+#ifndef DWIN_NATIVE_TEXT_CHARS
+#define DWIN_NATIVE_TEXT_CHARS 256
+#endif
+
+// The panel's built-in fonts as LVGL fonts. Labels using them are drawn with
+// CMD_DRAW_STRING: printable ASCII only, solid color (no anti-aliasing or
+// opacity). Glyphs the panel cannot draw (partly clipped on the left or
+// right, drawn into a layer or with the queue full) are rasterized by LVGL in
+// DWIN_FONT_FALLBACK instead, centered in the panel font's cell.
+#ifndef DWIN_FONT_FALLBACK
+#define DWIN_FONT_FALLBACK LV_FONT_DEFAULT
+#endif
+
+extern const lv_font_t dwin_font_6x12;
+extern const lv_font_t dwin_font_8x16;
+extern const lv_font_t dwin_font_10x20;
+extern const lv_font_t dwin_font_12x24;
+extern const lv_font_t dwin_font_14x28;
+extern const lv_font_t dwin_font_16x32;
+extern const lv_font_t dwin_font_20x40;
+extern const lv_font_t dwin_font_24x48;
+extern const lv_font_t dwin_font_28x56;
+extern const lv_font_t dwin_font_32x64;
+
+typedef struct {
+  uint32_t strings;       // CMD_DRAW_STRING frames sent
+  uint32_t glyphs;        // Characters drawn by the panel instead of LVGL
+  uint32_t fallback;      // Panel-font glyphs rasterized in DWIN_FONT_FALLBACK
+  uint32_t dropped;       // Sprites lost: queue full or transformed sprite
+  uint32_t sprites;       // CMD_VIRT_COPY_PASTE frames for sprites
+  uint32_t rects;         // CMD_DRAW_RECT frames for fills, borders and frames
+  uint32_t lines;         // CMD_DRAW_LINE frames
+  uint32_t skipped_px;    // Flushed pixels the primitives had already drawn
+} dwin_draw_stats_t;
+
+void dwin_draw_ctx_init(lv_disp_drv_t* disp_drv, lv_draw_ctx_t* draw_ctx);
+void dwin_draw_ctx_deinit(lv_disp_drv_t* disp_drv, lv_draw_ctx_t* draw_ctx);
+bool dwin_draw_native_begin(const lv_color_t* buf);
+bool dwin_draw_native_diff_row(const lv_color_t* row, int32_t x1, int32_t x2, int32_t y,
+                               int32_t* changed_x1, int32_t* changed_x2);
+void dwin_draw_native_end(const lv_color_t* buf);
+const dwin_draw_stats_t* dwin_draw_get_stats();
@@ -0,0 +1,137 @@
+#pragma once
+#include <stdint.h>
+#include <lvgl.h>
+#include <dwin.h>
+
+//==============================================================================
+// DWIN FLUSH AREA ENCODERS
+//==============================================================================
+// Each encoder turns a block of LVGL pixels into DWIN drawing commands.
+// px points to the top-left pixel of the block, stride is the number of
+// pixels between two rows of the source buffer, and (x, y) is the position
+// of the block on the panel.
+
+// Runs shorter than this are cheaper as batched points than as a line segment.
+#ifndef DWIN_SPAN_MIN_RUN
+#define DWIN_SPAN_MIN_RUN 5
+#endif
+
+// Isolated pixels collected per flush before a batch is forced out, and the
+// number of distinct colors a batch can hold.
+#ifndef DWIN_POINT_BATCH_MAX
+#define DWIN_POINT_BATCH_MAX 2048
+#endif
+#ifndef DWIN_POINT_BATCH_COLORS
+#define DWIN_POINT_BATCH_COLORS 32
+#endif
+
+// Pixels the rectangle encoder can analyse at once; taller blocks are split
+// into bands of rows that fit.
+#ifndef DWIN_RECT_MAX_AREA
+#define DWIN_RECT_MAX_AREA (DWIN_WIDTH * 20)
+#endif
+
+// Pixel comparisons the rectangle encoder may spend per pixel of a block before
+// the rest of the block falls back to horizontal runs.
+#ifndef DWIN_RECT_WORK_PER_PX
+#define DWIN_RECT_WORK_PER_PX 4
+#endif
+
+// The selector analyses blocks in tiles of this many rows and picks an
+// encoding per tile when that is cheaper than one encoding for the block.
+#ifndef DWIN_SELECT_TILE_ROWS
+#define DWIN_SELECT_TILE_ROWS 10
+#endif
+#ifndef DWIN_SELECT_MAX_TILES
+#define DWIN_SELECT_MAX_TILES 8
+#endif
+
+// Distinct colors tracked by the analysis pass before a block counts as "many colors".
+#ifndef DWIN_ANALYSIS_COLORS
+#define DWIN_ANALYSIS_COLORS 16
+#endif
+
+typedef enum {
+  DWIN_ENC_AUTO = -1,   // Let the cost model decide (default)
+  DWIN_ENC_SOLID = 0,   // One CMD_DRAW_RECT fill
+  DWIN_ENC_BITMAP,      // 1 bpp CMD_DRAW_BITMAP, two colors only
+  DWIN_ENC_SPANS,       // Horizontal runs + batched points
+  DWIN_ENC_RECTS,       // Greedy same-color rectangles
+  DWIN_ENC_POINTS,      // Color-bucketed CMD_SET_POINT batches
+  DWIN_ENC_BANDS,       // Row- or column-constant gradients as stacked fills
+  DWIN_ENC_COUNT
+} dwin_encoding_t;
+
+typedef struct {
+  uint32_t blocks[DWIN_ENC_COUNT];      // Areas or tiles sent with each encoding
+  uint32_t pixels[DWIN_ENC_COUNT];      // Pixels covered by them
+  uint32_t est_bytes[DWIN_ENC_COUNT];   // Wire bytes the cost model predicted for them
+  uint32_t areas;                       // Blocks passed to dwin_encode_block()
+  uint32_t tiled_areas;                 // Blocks that were split into per-tile decisions
+  uint32_t quantized_px;                // Pixels changed by the quantization stage
+} dwin_encoder_stats_t;
+
+const dwin_encoder_stats_t* dwin_encoder_get_stats();
+void dwin_encoder_reset_stats();
+const char* dwin_encoding_name(dwin_encoding_t encoding);
+
+/**
+ * @brief Forces one encoding for every block where it applies (for benchmarking).
+ * @note Single-color blocks always stay one CMD_DRAW_RECT fill.
+ * @param encoding DWIN_ENC_AUTO restores the cost-model selector.
+ */
+void dwin_encoder_force(dwin_encoding_t encoding);
+
+void dwin_encode_block(const lv_color_t* px, int32_t stride, int32_t x, int32_t y, int32_t w, int32_t h);
+dwin_encoding_t dwin_encoder_choose(const lv_color_t* px, int32_t stride, int32_t w, int32_t h, uint32_t* cost);
+void dwin_encode_spans(const lv_color_t* px, int32_t stride, int32_t x, int32_t y, int32_t w, int32_t h);
+void dwin_encode_rects(const lv_color_t* px, int32_t stride, int32_t x, int32_t y, int32_t w, int32_t h);
+void dwin_encode_points(const lv_color_t* px, int32_t stride, int32_t x, int32_t y, int32_t w, int32_t h);
+void dwin_encode_bands(const lv_color_t* px, int32_t stride, int32_t x, int32_t y, int32_t w, int32_t h);
+void dwin_encode_bitmap(const lv_color_t* px, int32_t stride, int32_t x, int32_t y, int32_t w, int32_t h,
+                        lv_color_t color1, lv_color_t color0);
+
+//==============================================================================
+// COLOR QUANTIZATION
+//==============================================================================
+// Optional lossy stage run on each flushed area before it is diffed and
+// encoded. Anti-aliasing, shadows and gradients leave many nearly identical
+// colors that break runs, rectangles and 2-color bitmaps; merging them trades
+// fidelity for fewer bytes. Errors are measured in 8-bit units, weighted
+// 3:6:1 for red, green and blue.
+
+typedef enum {
+  DWIN_QUANT_LOSSLESS = 0,  // Pixels are sent as LVGL rendered them (default)
+  DWIN_QUANT_PALETTE,       // Snap every color to an evenly spaced palette
+  DWIN_QUANT_TOLERANCE      // Reuse the color on the left or above when within the error budget
+} dwin_quant_mode_t;
+
+#ifndef DWIN_QUANTIZE
+#define DWIN_QUANTIZE DWIN_QUANT_LOSSLESS
+#endif
+
+// DWIN_QUANT_PALETTE: levels per channel are 2^bits for red and blue and
+// twice that for green. DWIN_QUANT_TOLERANCE: the error budget.
+#ifndef DWIN_QUANT_PALETTE_BITS
+#define DWIN_QUANT_PALETTE_BITS 4
+#endif
+#ifndef DWIN_QUANT_TOLERANCE_BUDGET
+#define DWIN_QUANT_TOLERANCE_BUDGET 12
+#endif
+
+void dwin_quantize_set(dwin_quant_mode_t mode, uint8_t level);
+dwin_quant_mode_t dwin_quantize_mode();
+uint8_t dwin_quantize_max_error();
+uint8_t dwin_quantize_error(uint16_t a, uint16_t b);
+lv_color_t dwin_quantize_color(lv_color_t color);
+void dwin_quantize_area(lv_color_t* px, int32_t stride, int32_t w, int32_t h);
+
+//==============================================================================
+// COLOR-BUCKETED POINT BATCH
+//==============================================================================
+// Pixels added to the batch are grouped by color and sent as multi-coordinate
+// CMD_SET_POINT frames, so header, color and tail are paid once per color and
+// frame instead of once per pixel.
+
+void dwin_point_batch_add(uint16_t dwin_color, uint16_t x, uint16_t y);
+void dwin_point_batch_flush();
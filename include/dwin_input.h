@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+#include <lvgl.h>
+
+//==============================================================================
+// ROTARY KNOB INPUT
+//==============================================================================
+// The Ender 3 V2 display's rotary knob as an LVGL encoder input device. Pin
+// interrupts decode the quadrature signal and debounce the push button into
+// a lock-free queue of events, time-stamped at the edge; LVGL drains it in
+// its indev read callback. Each event wakes the loop() task through
+// dwin_input_wait(), so a turn is read as soon as it happens instead of on
+// LVGL's next read period. The time from the edge to the end of the first
+// flush LVGL starts after reading it is measured as the input latency.
+
+// ESP32 pins wired to the knob's A, B and push-button contacts (closing to GND).
+#ifndef DWIN_KNOB_PIN_A
+#define DWIN_KNOB_PIN_A 25
+#endif
+#ifndef DWIN_KNOB_PIN_B
+#define DWIN_KNOB_PIN_B 26
+#endif
+#ifndef DWIN_KNOB_PIN_BTN
+#define DWIN_KNOB_PIN_BTN 27
+#endif
+
+// Quadrature steps per detent, and 1 to swap the turning direction.
+#ifndef DWIN_KNOB_STEPS_PER_DETENT
+#define DWIN_KNOB_STEPS_PER_DETENT 4
+#endif
+#ifndef DWIN_KNOB_REVERSE
+#define DWIN_KNOB_REVERSE 0
+#endif
+
+// Button edges this soon after an accepted one are contact bounce.
+#ifndef DWIN_KNOB_DEBOUNCE_MS
+#define DWIN_KNOB_DEBOUNCE_MS 5
+#endif
+
+// Events the queue holds between two reads by LVGL (power of two).
+#ifndef DWIN_KNOB_QUEUE
+#define DWIN_KNOB_QUEUE 32
+#endif
+
+typedef struct {
+  uint32_t steps;             // Detents turned, either way
+  uint32_t presses;           // Button presses
+  uint32_t bounces;           // Button edges ignored as bounce
+  uint32_t dropped;           // Events lost to a full queue
+  uint32_t latencies;         // Inputs followed by a completed flush
+  uint32_t latency_last_us;   // Edge to the end of the first flush after LVGL read it
+  uint32_t latency_max_us;
+  uint32_t latency_sum_us;
+} dwin_input_stats_t;
+
+lv_indev_t* dwin_input_init();
+void dwin_input_wait(uint32_t ms);
+void dwin_input_quadrature(bool a, bool b);
+void dwin_input_button(bool pressed);
+void dwin_input_flush_begin();
+void dwin_input_flush_done();
+const dwin_input_stats_t* dwin_input_get_stats();
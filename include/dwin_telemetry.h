@@ -0,0 +1,91 @@
+#pragma once
+#include <stdint.h>
+#include <lvgl.h>
+#include <dwin.h>
+#include <dwin_encoder.h>
+
+//==============================================================================
+// DWIN FLUSH TELEMETRY
+//==============================================================================
+// Per-flush instrumentation of the driver: area, main encoding, bytes and
+// frames sent, and where the time went. Encode time is the CPU time spent
+// turning LVGL's pixels into frames; transmit time is the time spent writing
+// them out (or waiting for room in the transmit ring) plus the wait for the
+// last byte to leave after encoding finished. Both come from the CPU cycle
+// counter on the ESP32 and from std::chrono::steady_clock on the host.
+//
+// Totals and log2 histograms cover a window that dwin_telemetry_report()
+// prints and restarts; the last DWIN_TELEMETRY_HISTORY flushes are kept one
+// by one.
+
+// 0 compiles the hooks out.
+#ifndef DWIN_TELEMETRY
+#define DWIN_TELEMETRY 1
+#endif
+
+// Period of the reports dwin_telemetry_poll() prints on Serial; 0 disables them.
+#ifndef DWIN_TELEMETRY_REPORT_MS
+#define DWIN_TELEMETRY_REPORT_MS 0
+#endif
+
+// Flush records kept for dwin_telemetry_history().
+#ifndef DWIN_TELEMETRY_HISTORY
+#define DWIN_TELEMETRY_HISTORY 32
+#endif
+
+// Histogram bucket i counts values from 2^i to 2^(i+1) - 1 (bucket 0 also
+// counts 0); the last bucket counts everything above.
+#define DWIN_TELEMETRY_BUCKETS 16
+
+typedef struct {
+  lv_area_t area;         // Flushed area
+  int8_t encoding;        // Encoding that sent most pixels, DWIN_ENC_AUTO if none were encoded
+  uint16_t frames;        // Frames sent
+  uint32_t bytes;         // Bytes sent
+  uint32_t encode_us;     // Encoding, without the time spent writing
+  uint32_t transmit_us;   // Writing, plus draining the transmit ring after encoding
+} dwin_flush_record_t;
+
+typedef struct {
+  uint32_t encode_us[DWIN_TELEMETRY_BUCKETS];
+  uint32_t transmit_us[DWIN_TELEMETRY_BUCKETS];
+  uint32_t bytes[DWIN_TELEMETRY_BUCKETS];
+  uint32_t px[DWIN_TELEMETRY_BUCKETS];
+} dwin_telemetry_hist_t;
+
+typedef struct {
+  uint32_t started_ms;                    // millis() when the window started
+  uint32_t flushes;
+  uint32_t px;                            // Pixels flushed
+  uint32_t bytes;
+  uint32_t frames;
+  uint32_t encode_us;
+  uint32_t transmit_us;
+  uint32_t max_encode_us;
+  uint32_t max_transmit_us;
+  uint32_t by_encoding[DWIN_ENC_COUNT];   // Flushes by main encoding
+  uint32_t not_encoded;                   // Flushes fully skipped, copied or drawn natively
+  dwin_telemetry_hist_t hist;
+} dwin_telemetry_t;
+
+#if DWIN_TELEMETRY
+uint32_t dwin_telemetry_ticks();
+void dwin_telemetry_flush_begin(const lv_area_t* area);
+void dwin_telemetry_flush_encoded();
+void dwin_telemetry_flush_done();
+void dwin_telemetry_frame();
+void dwin_telemetry_write(uint32_t bytes, uint32_t start_ticks);
+#else
+static inline uint32_t dwin_telemetry_ticks() { return 0; }
+static inline void dwin_telemetry_flush_begin(const lv_area_t* area) {}
+static inline void dwin_telemetry_flush_encoded() {}
+static inline void dwin_telemetry_flush_done() {}
+static inline void dwin_telemetry_frame() {}
+static inline void dwin_telemetry_write(uint32_t bytes, uint32_t start_ticks) {}
+#endif
+
+const dwin_telemetry_t* dwin_telemetry_get();
+uint8_t dwin_telemetry_history(dwin_flush_record_t* records, uint8_t max_records);
+void dwin_telemetry_reset();
+void dwin_telemetry_report();
+void dwin_telemetry_poll();
@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+#include <lvgl.h>
+#include <dwin.h>
+
+//==============================================================================
+// DWIN TILE CACHE
+//==============================================================================
+// An index of DWIN_TILE_SIZE x DWIN_TILE_SIZE tiles known to be in the
+// panel's VRAM, keyed by a hash of their pixels. Each flushed area is cut into
+// tiles on the screen's tile grid and a tile found in the index is copied from
+// VRAM with CMD_VIRT_COPY_PASTE instead of being encoded.
+//
+// The T5UIC1 cannot write pixels into VRAM over UART, and it cannot copy from
+// the visible screen, so the index only learns VRAM content the application
+// describes with dwin_tiles_index(): a region of a picture decoded with
+// dwin_atlas_load() whose pixels the firmware also has (e.g. the checkbox and
+// button states of the icon picture). While the index holds tiles, flushed
+// areas are rounded out to the tile grid so widgets placed on it always hit.
+
+#ifndef DWIN_TILE_SIZE
+#define DWIN_TILE_SIZE 16
+#endif
+
+// Tiles the index holds, in sets of DWIN_TILE_CACHE_WAYS; the least recently
+// used tile of a set is evicted. The number of sets must be a power of two.
+#ifndef DWIN_TILE_CACHE_ENTRIES
+#define DWIN_TILE_CACHE_ENTRIES 256
+#endif
+#ifndef DWIN_TILE_CACHE_WAYS
+#define DWIN_TILE_CACHE_WAYS 4
+#endif
+
+typedef struct {
+  int16_t x, y;           // Tile position on screen
+  uint8_t page;           // VRAM page holding the same pixels
+  uint16_t src_x, src_y;  // Position in that page
+} dwin_tile_hit_t;
+
+typedef struct {
+  uint32_t entries;       // Tiles in the index
+  uint32_t indexed;       // Tiles added by dwin_tiles_index()
+  uint32_t uniform;       // Single-color tiles not indexed (a fill is as cheap)
+  uint32_t evictions;     // Tiles pushed out of a full set
+  uint32_t lookups;       // Flushed tiles looked up
+  uint32_t hits;          // Lookups found in the index
+  uint32_t copies;        // CMD_VIRT_COPY_PASTE frames sent for hits
+  uint32_t copied_px;     // Pixels copied from VRAM instead of sent
+} dwin_tile_stats_t;
+
+uint32_t dwin_tiles_index(uint8_t page, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                          const uint16_t* px, uint32_t stride);
+void dwin_tiles_forget_page(uint8_t page);
+void dwin_tiles_rounder(lv_disp_drv_t* disp_drv, lv_area_t* area);
+uint16_t dwin_tiles_match(const lv_area_t* area, const lv_color_t* color_p,
+                          dwin_tile_hit_t* hits, uint16_t max_hits);
+uint16_t dwin_tiles_run(const dwin_tile_hit_t* hits, uint16_t n);
+void dwin_tiles_copy(const dwin_tile_hit_t* hits, uint16_t n);
+const dwin_tile_stats_t* dwin_tiles_get_stats();
+void dwin_tiles_reset_stats();
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+//==============================================================================
+// DWIN WIRE TRACE
+//==============================================================================
+// Capture of every frame dwin_send_frame() sends, with its time, so a real
+// session can be replayed in the host emulator (dwin_bench --replay) and its
+// throughput, frame mix and final screen compared across builds.
+//
+// Format, little-endian:
+//   header  "DWTR" [version = 1] [baud: uint32]
+//   record  [dt: varint] [len: varint] [len bytes]
+// dt is the time since the previous record in microseconds (since the
+// header for the first one) and the bytes are the frame without its 0xAA
+// header and CC 33 C3 3C tail. Varints are LEB128: 7 bits per byte, low
+// bits first, high bit set on every byte but the last.
+
+// 0 compiles the capture hook out.
+#ifndef DWIN_TRACE
+#define DWIN_TRACE 1
+#endif
+
+#define DWIN_TRACE_MAGIC "DWTR"
+#define DWIN_TRACE_VERSION 1
+
+// Receives the trace bytes, in order.
+typedef void (*dwin_trace_sink_fn)(const uint8_t* data, size_t len, void* ctx);
+
+typedef struct {
+  uint32_t frames;        // Records written
+  uint32_t frame_bytes;   // Wire bytes of the traced frames
+  uint32_t trace_bytes;   // Bytes given to the sink, header included
+} dwin_trace_stats_t;
+
+#if DWIN_TRACE
+void dwin_trace_frame(const uint8_t* frame, uint32_t len);
+#else
+static inline void dwin_trace_frame(const uint8_t* frame, uint32_t len) {}
+#endif
+
+bool dwin_trace_start(dwin_trace_sink_fn sink, void* ctx, uint32_t baud);
+void dwin_trace_stop();
+bool dwin_trace_active();
+void dwin_trace_serial_sink(const uint8_t* data, size_t len, void* ctx);
+const dwin_trace_stats_t* dwin_trace_get_stats();
+size_t dwin_trace_read_varint(const uint8_t* data, size_t len, uint32_t* value);
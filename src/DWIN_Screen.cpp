@@ -1,5 +1,13 @@
 #include "DWIN_Screen.h"
 
+#if DWIN_SHADOW_ENTRIES < 1 || DWIN_SHADOW_ENTRIES > 255
+#error "DWIN_SHADOW_ENTRIES debe estar entre 1 y 255"
+#endif
+
+#if DWIN_BATCH_BYTES < DWIN_MAX_FRAME_DATA
+#error "DWIN_BATCH_BYTES debe admitir una trama completa"
+#endif
+
 DWINScreen::DWINScreen(int8_t cs, int8_t sck, int8_t mosi, int8_t miso) {
     csPin = cs;
     sckPin = sck;
@@ -63,108 +71,354 @@ uint8_t DWINScreen::receiveByte() {
     return spi->transfer(0xFF); // Enviar dummy byte para recibir
 }
 
-void DWINScreen::writeText(uint16_t address, const char* text) {
-    uint8_t len = strlen(text);
-    
+void DWINScreen::startWriteFrame(uint16_t address, uint8_t len) {
     beginTransaction();
     
     // Header: 5A A5
     sendWord(DWIN_FRAME_HEADER);
     
-    // Longitud de datos (comando + dirección + datos + terminador)
-    sendByte(len + 4);
+    // Longitud de datos (comando + dirección + datos)
+    sendByte(len + 3);
     
     // Comando de escritura
     sendByte(DWIN_WRITE);
     
     // Dirección VP
     sendWord(address);
-    
-    // Enviar texto
+}
+
+void DWINScreen::sendWriteFrame(uint16_t address, const uint8_t* data, uint8_t len) {
+    startWriteFrame(address, len);
     for (uint8_t i = 0; i < len; i++) {
-        sendByte(text[i]);
+        sendByte(data[i]);
     }
-    
-    // Agregar terminador nulo
-    sendByte(0x00);
-    
     endTransaction();
     delayMicroseconds(100);
+    stats.writeFrames++;
 }
 
-void DWINScreen::writeText(uint16_t address, String text) {
-    writeText(address, text.c_str());
+void DWINScreen::write(uint16_t address, const uint8_t* data, uint8_t len) {
+    stats.writes++;
+    if (shadowEnabled && shadowWrite(address, data, len)) {
+        // Fuera de un lote lo que cambió sale ya
+        if (!batching) {
+            flushShadow();
+        }
+        return;
+    }
+    if (batching) {
+        stageWrite(address, data, len);
+        return;
+    }
+    sendWriteFrame(address, data, len);
 }
 
-void DWINScreen::clearTextArea(uint16_t address, uint8_t length) {
-    beginTransaction();
-    
-    // Header
-    sendWord(DWIN_FRAME_HEADER);
-    
-    // Longitud
-    sendByte(length + 3);
-    
-    // Comando
-    sendByte(DWIN_WRITE);
-    
-    // Dirección
-    sendWord(address);
+// Guarda una escritura en el lote
+void DWINScreen::stageWrite(uint16_t address, const uint8_t* data, uint8_t len) {
+    uint32_t end = (uint32_t)address + (len + 1) / 2;
+    
+    for (uint8_t i = 0; i < batchCount; i++) {
+        BatchWrite& w = batch[i];
+        // La misma escritura repetida: basta con el último valor
+        if (w.address == address && w.len == len) {
+            memcpy(batchData + w.offset, data, len);
+            return;
+        }
+        // Si se solapa con otra, el orden importa: se envía lo anterior primero
+        if (address < w.address + (w.len + 1) / 2 && w.address < end) {
+            sendBatch();
+            break;
+        }
+    }
     
-    // Llenar con espacios
-    for (uint8_t i = 0; i < length; i++) {
-        sendByte(' ');
+    if (batchCount == DWIN_BATCH_WRITES || batchBytes + len > DWIN_BATCH_BYTES) {
+        sendBatch();
     }
     
-    endTransaction();
-    delayMicroseconds(100);
+    BatchWrite& w = batch[batchCount++];
+    w.address = address;
+    w.offset = batchBytes;
+    w.len = len;
+    memcpy(batchData + batchBytes, data, len);
+    batchBytes += len;
 }
 
-void DWINScreen::writeVariable(uint16_t address, uint16_t value) {
-    beginTransaction();
+// Envía el lote ordenado por dirección, una trama por serie de direcciones consecutivas
+void DWINScreen::sendBatch() {
+    // Ordenación por inserción: el lote es pequeño
+    for (uint8_t i = 1; i < batchCount; i++) {
+        BatchWrite w = batch[i];
+        uint8_t j = i;
+        while (j > 0 && batch[j - 1].address > w.address) {
+            batch[j] = batch[j - 1];
+            j--;
+        }
+        batch[j] = w;
+    }
     
-    // Header
-    sendWord(DWIN_FRAME_HEADER);
+    uint8_t first = 0;
+    while (first < batchCount) {
+        // Una escritura de bytes impares deja el último word a medias y corta la serie
+        uint8_t last = first;
+        uint16_t len = batch[first].len;
+        while (last + 1 < batchCount) {
+            const BatchWrite& w = batch[last];
+            const BatchWrite& next = batch[last + 1];
+            if ((w.len & 1) || w.address + w.len / 2 != next.address || len + next.len > DWIN_MAX_FRAME_DATA) {
+                break;
+            }
+            len += next.len;
+            last++;
+        }
+        
+        startWriteFrame(batch[first].address, len);
+        for (uint8_t i = first; i <= last; i++) {
+            const uint8_t* data = batchData + batch[i].offset;
+            for (uint8_t b = 0; b < batch[i].len; b++) {
+                sendByte(data[b]);
+            }
+        }
+        endTransaction();
+        delayMicroseconds(100);
+        stats.writeFrames++;
+        
+        first = last + 1;
+    }
     
-    // Longitud (comando + dirección + 2 bytes de datos)
-    sendByte(5);
+    batchCount = 0;
+    batchBytes = 0;
+}
+
+void DWINScreen::beginBatch() {
+    batching = true;
+}
+
+void DWINScreen::endBatch() {
+    flushShadow();
+    sendBatch();
+    batching = false;
+}
+
+// Primera entrada de la tabla de sombra con dirección >= address
+uint8_t DWINScreen::shadowFind(uint16_t address) const {
+    uint8_t lo = 0;
+    uint8_t hi = shadowCount;
+    while (lo < hi) {
+        uint8_t mid = (lo + hi) / 2;
+        if (shadow[mid].address < address) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Entradas [first, last) de la tabla de sombra que se solapan con las
+// direcciones [address, end)
+void DWINScreen::shadowOverlap(uint16_t address, uint32_t end, uint8_t& first, uint8_t& last) const {
+    first = shadowFind(address);
+    if (first > 0 && shadow[first - 1].address + (shadow[first - 1].len + 1) / 2 > address) {
+        first--;
+    }
+    last = first;
+    while (last < shadowCount && shadow[last].address < end) {
+        last++;
+    }
+}
+
+// Quita las entradas [first, last) de la tabla de sombra
+void DWINScreen::shadowRemove(uint8_t first, uint8_t last) {
+    for (uint8_t i = first; i < last; i++) {
+        if (shadow[i].dirty) {
+            shadowDirty--;
+        }
+    }
+    memmove(&shadow[first], &shadow[last], (shadowCount - last) * sizeof(ShadowEntry));
+    shadowCount -= last - first;
+}
+
+// Pasa una escritura por la tabla de sombra. Devuelve true si queda resuelta en
+// ella (omitida o pendiente de flushShadow) y false si hay que enviarla ya.
+bool DWINScreen::shadowWrite(uint16_t address, const uint8_t* data, uint8_t len) {
+    uint8_t pos = shadowFind(address);
+    
+    if (pos < shadowCount && shadow[pos].address == address && shadow[pos].len == len) {
+        ShadowEntry& e = shadow[pos];
+        if (memcmp(e.value, data, len) == 0) {
+            stats.suppressed++;
+            return true;
+        }
+        memcpy(e.value, data, len);
+        e.written = true;
+        if (!e.dirty) {
+            e.dirty = true;
+            shadowDirty++;
+        }
+        return true;
+    }
     
-    // Comando
-    sendByte(DWIN_WRITE);
+    // Las entradas que pisa dejan de valer. Si alguna estaba pendiente se envía
+    // antes, para que llegue a la pantalla antes que esta escritura.
+    uint8_t first;
+    uint8_t last;
+    shadowOverlap(address, (uint32_t)address + (len + 1) / 2, first, last);
+    for (uint8_t i = first; i < last; i++) {
+        if (shadow[i].dirty) {
+            flushShadow();
+            break;
+        }
+    }
+    shadowRemove(first, last);
+    pos = first;
     
-    // Dirección
-    sendWord(address);
+    if (len > DWIN_SHADOW_VALUE_BYTES) {
+        return false;
+    }
     
-    // Valor (16 bits)
-    sendWord(value);
+    // Tabla llena: se libera una entrada ya enviada, rotando para no vaciar siempre la misma
+    if (shadowCount == DWIN_SHADOW_ENTRIES) {
+        if (shadowDirty == shadowCount) {
+            flushShadow();
+        }
+        uint8_t i = shadowEvict % shadowCount;
+        while (shadow[i].dirty) {
+            i = (i + 1) % shadowCount;
+        }
+        shadowRemove(i, i + 1);
+        shadowEvict = i + 1;
+        pos = shadowFind(address);
+    }
     
-    endTransaction();
-    delayMicroseconds(100);
+    memmove(&shadow[pos + 1], &shadow[pos], (shadowCount - pos) * sizeof(ShadowEntry));
+    shadowCount++;
+    ShadowEntry& e = shadow[pos];
+    e.address = address;
+    e.len = len;
+    e.dirty = true;
+    e.written = true;
+    memcpy(e.value, data, len);
+    shadowDirty++;
+    return true;
 }
 
-void DWINScreen::writeVariable(uint16_t address, int32_t value) {
-    beginTransaction();
+// Envía las entradas cambiadas, en orden de dirección y agrupadas como un lote
+void DWINScreen::flushShadow() {
+    if (shadowDirty == 0) {
+        return;
+    }
+    for (uint8_t i = 0; i < shadowCount; i++) {
+        if (shadow[i].dirty) {
+            stageWrite(shadow[i].address, shadow[i].value, shadow[i].len);
+            shadow[i].dirty = false;
+        }
+    }
+    shadowDirty = 0;
     
-    // Header
-    sendWord(DWIN_FRAME_HEADER);
+    // Dentro de un lote salen con endBatch()
+    if (!batching) {
+        sendBatch();
+    }
+}
+
+// Pone en la tabla de sombra lo que una lectura encontró en la pantalla, que
+// puede haber cambiado desde el panel táctil. Las entradas que la lectura solo
+// cubre en parte se olvidan; las pendientes de enviar y las escritas después de
+// enviar la lectura se mantienen, porque la respuesta trae un valor anterior.
+void DWINScreen::shadowRefresh(uint16_t address, const uint16_t* values, uint8_t words) {
+    uint8_t first;
+    uint8_t last;
+    shadowOverlap(address, (uint32_t)address + words, first, last);
+    
+    uint8_t i = first;
+    while (i < last) {
+        ShadowEntry& e = shadow[i];
+        if (e.dirty || e.written) {
+            i++;
+        } else if (e.address >= address && e.address + (e.len + 1) / 2 <= address + words) {
+            const uint16_t* v = values + (e.address - address);
+            for (uint8_t b = 0; b < e.len; b++) {
+                e.value[b] = (b & 1) ? v[b / 2] & 0xFF : v[b / 2] >> 8;
+            }
+            i++;
+        } else {
+            shadowRemove(i, i + 1);
+            last--;
+        }
+    }
+}
+
+// Las lecturas que salen ahora ven todo lo escrito hasta aquí
+void DWINScreen::shadowReadSent() {
+    for (uint8_t i = 0; i < shadowCount; i++) {
+        shadow[i].written = false;
+    }
+}
+
+// Olvida lo escrito, p. ej. tras reiniciar la pantalla; las entradas pendientes se envían
+void DWINScreen::clearShadow() {
+    flushShadow();
+    shadowCount = 0;
+    shadowEvict = 0;
+}
+
+// Olvida lo escrito en words direcciones desde address, p. ej. tras cambiarlas
+// desde el panel táctil; las entradas pendientes se envían
+void DWINScreen::clearShadow(uint16_t address, uint8_t words) {
+    flushShadow();
+    uint8_t first;
+    uint8_t last;
+    shadowOverlap(address, (uint32_t)address + words, first, last);
+    shadowRemove(first, last);
+}
+
+void DWINScreen::enableShadow(bool enable) {
+    if (!enable) {
+        clearShadow();
+    }
+    shadowEnabled = enable;
+}
+
+void DWINScreen::writeText(uint16_t address, const char* text) {
+    uint8_t data[DWIN_MAX_FRAME_DATA];
     
-    // Longitud (comando + dirección + 4 bytes de datos)
-    sendByte(7);
+    // Texto y terminador nulo
+    size_t len = min(strlen(text), (size_t)DWIN_MAX_FRAME_DATA - 1);
+    memcpy(data, text, len);
+    data[len] = 0x00;
     
-    // Comando
-    sendByte(DWIN_WRITE);
+    write(address, data, len + 1);
+}
+
+void DWINScreen::writeText(uint16_t address, String text) {
+    writeText(address, text.c_str());
+}
+
+void DWINScreen::clearTextArea(uint16_t address, uint8_t length) {
+    uint8_t data[DWIN_MAX_FRAME_DATA];
     
-    // Dirección
-    sendWord(address);
+    // Llenar con espacios
+    length = min(length, (uint8_t)DWIN_MAX_FRAME_DATA);
+    memset(data, ' ', length);
     
+    write(address, data, length);
+}
+
+void DWINScreen::writeVariable(uint16_t address, uint16_t value) {
+    // Valor (16 bits) - Big endian
+    uint8_t data[2] = {(uint8_t)(value >> 8), (uint8_t)(value & 0xFF)};
+    write(address, data, sizeof(data));
+}
+
+void DWINScreen::writeVariable(uint16_t address, int32_t value) {
     // Valor (32 bits) - Big endian
-    sendByte((value >> 24) & 0xFF);
-    sendByte((value >> 16) & 0xFF);
-    sendByte((value >> 8) & 0xFF);
-    sendByte(value & 0xFF);
-    
-    endTransaction();
-    delayMicroseconds(100);
+    uint8_t data[4] = {
+        (uint8_t)((value >> 24) & 0xFF),
+        (uint8_t)((value >> 16) & 0xFF),
+        (uint8_t)((value >> 8) & 0xFF),
+        (uint8_t)(value & 0xFF)
+    };
+    write(address, data, sizeof(data));
 }
 
 void DWINScreen::setBacklight(uint8_t brightness) {
@@ -172,9 +426,7 @@ void DWINScreen::setBacklight(uint8_t brightness) {
     writeVariable(0x0082, (uint16_t)brightness);
 }
 
-uint16_t DWINScreen::readVariable(uint16_t address) {
-    uint16_t value = 0;
-    
+void DWINScreen::sendReadRequest(uint16_t address, uint8_t words) {
     beginTransaction();
     
     // Header
@@ -189,29 +441,188 @@ uint16_t DWINScreen::readVariable(uint16_t address) {
     // Dirección
     sendWord(address);
     
-    // Longitud a leer (1 word = 2 bytes)
-    sendByte(0x01);
+    // Longitud a leer en words
+    sendByte(words);
     
     endTransaction();
+    stats.readFrames++;
+}
+
+// Lee la respuesta a una lectura: 5A A5 len 83 addrH addrL n datos.
+// Devuelve false si no es la respuesta a address y words.
+bool DWINScreen::receiveResponse(uint16_t address, uint16_t* values, uint8_t words) {
+    beginTransaction();
     
-    // Esperar respuesta
-    delay(10);
+    // Header de respuesta (5A A5), longitud (comando + dirección + n + datos),
+    // comando, dirección y words leídos
+    bool valid = ((uint16_t)receiveByte() << 8 | receiveByte()) == DWIN_FRAME_HEADER;
+    valid = valid && receiveByte() == 4 + 2 * words;
+    valid = valid && receiveByte() == DWIN_READ;
+    valid = valid && ((uint16_t)receiveByte() << 8 | receiveByte()) == address;
+    valid = valid && receiveByte() == words;
+    
+    // Leer valores
+    for (uint8_t i = 0; valid && i < words; i++) {
+        values[i] = (uint16_t)receiveByte() << 8;
+        values[i] |= receiveByte();
+    }
     
-    // Leer respuesta
-    beginTransaction();
+    endTransaction();
+    if (!valid) {
+        stats.readErrors++;
+    }
+    return valid;
+}
+
+uint16_t DWINScreen::readVariable(uint16_t address) {
+    uint16_t value = 0;
     
-    // Saltar header de respuesta (5A A5)
-    receiveByte();
-    receiveByte();
+    // La lectura debe ver las escrituras pendientes
+    flushShadow();
+    sendBatch();
+    
+    // Las respuestas llegan en orden: primero las de las lecturas asíncronas en curso
+    if (inFlightCount > 0) {
+        uint32_t waited = millis() - readSentMs;
+        if (waited < DWIN_READ_DELAY_MS) {
+            delay(DWIN_READ_DELAY_MS - waited);
+        }
+        receiveReads();
+    }
     
-    // Saltar longitud
-    receiveByte();
+    shadowReadSent();
+    sendReadRequest(address, 1);
     
-    // Leer valor
-    value = (uint16_t)receiveByte() << 8;
-    value |= receiveByte();
+    // Esperar respuesta
+    delay(DWIN_READ_DELAY_MS);
     
-    endTransaction();
+    // Leer respuesta; 0 si no es la esperada
+    if (receiveResponse(address, &value, 1)) {
+        shadowRefresh(address, &value, 1);
+    }
     
     return value;
-}
\ No newline at end of file
+}
+
+// Encola una lectura de words consecutivos. Devuelve false si la cola está llena.
+bool DWINScreen::requestVariable(uint16_t address, uint8_t words, DWINReadCallback callback, void* ctx) {
+    if (words == 0 || words > DWIN_MAX_READ_WORDS || readCount == DWIN_READ_QUEUE) {
+        return false;
+    }
+    ReadRequest& r = readQueue[readCount++];
+    r.address = address;
+    r.words = words;
+    r.callback = callback;
+    r.ctx = ctx;
+    return true;
+}
+
+// Envía las lecturas en cola de una vez, unidas en una trama por rango de direcciones
+void DWINScreen::sendReads() {
+    // Las lecturas deben ver las escrituras pendientes
+    flushShadow();
+    sendBatch();
+    
+    // Ordenación por inserción estable por dirección
+    inFlightCount = readCount;
+    for (uint8_t i = 0; i < readCount; i++) {
+        ReadRequest r = readQueue[i];
+        uint8_t j = i;
+        while (j > 0 && readsInFlight[j - 1].address > r.address) {
+            readsInFlight[j] = readsInFlight[j - 1];
+            j--;
+        }
+        readsInFlight[j] = r;
+    }
+    readCount = 0;
+    
+    // Lecturas que se solapan o se tocan comparten trama
+    spanCount = 0;
+    uint32_t spanEnd = 0;
+    for (uint8_t i = 0; i < inFlightCount; i++) {
+        const ReadRequest& r = readsInFlight[i];
+        uint32_t end = (uint32_t)r.address + r.words;
+        if (spanCount > 0) {
+            ReadSpan& span = readSpans[spanCount - 1];
+            uint32_t merged = max(spanEnd, end);
+            if (r.address <= spanEnd && merged - span.address <= DWIN_MAX_READ_WORDS) {
+                spanEnd = merged;
+                span.words = spanEnd - span.address;
+                span.count++;
+                continue;
+            }
+        }
+        ReadSpan& span = readSpans[spanCount++];
+        span.address = r.address;
+        span.words = r.words;
+        span.first = i;
+        span.count = 1;
+        spanEnd = end;
+    }
+    
+    spanNext = 0;
+    readRound++;
+    readsInSync = true;
+    shadowReadSent();
+    for (uint8_t s = 0; s < spanCount; s++) {
+        sendReadRequest(readSpans[s].address, readSpans[s].words);
+    }
+    readSentMs = millis();
+}
+
+// Lee las respuestas, en el orden de las peticiones, y completa cada lectura.
+// Tras una respuesta que no es la esperada las siguientes ya no se pueden
+// emparejar: esas lecturas fallan (callback con values NULL).
+// Los callbacks pueden llamar a readVariable(), requestVariable() o poll():
+// una llamada anidada lee antes las respuestas que faltan, y las lecturas
+// de cada trama se copian antes de sus callbacks por si salen otras nuevas.
+void DWINScreen::receiveReads() {
+    uint8_t round = readRound;
+    
+    while (round == readRound && spanNext < spanCount) {
+        ReadSpan span = readSpans[spanNext++];
+        uint16_t values[DWIN_MAX_READ_WORDS];
+        readsInSync = readsInSync && receiveResponse(span.address, values, span.words);
+        bool inSync = readsInSync;
+        if (inSync) {
+            shadowRefresh(span.address, values, span.words);
+        }
+        
+        ReadRequest done[DWIN_READ_QUEUE];
+        memcpy(done, &readsInFlight[span.first], span.count * sizeof(ReadRequest));
+        if (spanNext == spanCount) {
+            inFlightCount = 0;
+        }
+        
+        for (uint8_t i = 0; i < span.count; i++) {
+            const ReadRequest& r = done[i];
+            if (inSync) {
+                stats.reads++;
+            }
+            if (r.callback) {
+                r.callback(r.address, inSync ? values + (r.address - span.address) : NULL, inSync ? r.words : 0, r.ctx);
+            }
+        }
+    }
+}
+
+// Avanza las lecturas asíncronas sin bloquear; llamar desde loop()
+void DWINScreen::poll() {
+    if (inFlightCount > 0) {
+        if (millis() - readSentMs < DWIN_READ_DELAY_MS) {
+            return;
+        }
+        receiveReads();
+    }
+    if (readCount > 0) {
+        sendReads();
+    }
+}
+
+bool DWINScreen::readsPending() const {
+    return readCount > 0 || inFlightCount > 0;
+}
+
+const DWINScreenStats& DWINScreen::getStats() const {
+    return stats;
+}
@@ -12,6 +12,51 @@
 // Direcciones de memoria comunes
 #define DWIN_VP_TEXT_BASE 0x1000  // Dirección base para texto
 
+// Datos máximos de una trama: la longitud es un byte y cuenta comando y dirección
+#define DWIN_MAX_FRAME_DATA 252
+// Words máximos que se piden en una lectura
+#define DWIN_MAX_READ_WORDS 0x7C
+
+// Escrituras y bytes de datos que caben en un lote (beginBatch/endBatch)
+#ifndef DWIN_BATCH_WRITES
+#define DWIN_BATCH_WRITES 32
+#endif
+#ifndef DWIN_BATCH_BYTES
+#define DWIN_BATCH_BYTES 512
+#endif
+
+// Lecturas asíncronas que pueden esperar en cola
+#ifndef DWIN_READ_QUEUE
+#define DWIN_READ_QUEUE 32
+#endif
+
+// Tiempo que necesita la pantalla para preparar la respuesta a una lectura
+#ifndef DWIN_READ_DELAY_MS
+#define DWIN_READ_DELAY_MS 10
+#endif
+
+// Tabla de sombra (enableShadow): direcciones VP que recuerda, y bytes
+// máximos de un valor para guardarlo
+#ifndef DWIN_SHADOW_ENTRIES
+#define DWIN_SHADOW_ENTRIES 64
+#endif
+#ifndef DWIN_SHADOW_VALUE_BYTES
+#define DWIN_SHADOW_VALUE_BYTES 24
+#endif
+
+// Recibe los words leídos a partir de address; values es NULL (y words 0) si
+// la lectura falló
+typedef void (*DWINReadCallback)(uint16_t address, const uint16_t* values, uint8_t words, void* ctx);
+
+struct DWINScreenStats {
+    uint32_t writes;        // Escrituras pedidas
+    uint32_t writeFrames;   // Tramas de escritura enviadas
+    uint32_t reads;         // Lecturas asíncronas completadas
+    uint32_t readFrames;    // Tramas de lectura enviadas
+    uint32_t readErrors;    // Respuestas que no correspondían a la lectura pedida
+    uint32_t suppressed;    // Escrituras omitidas por la tabla de sombra: el valor no cambió
+};
+
 class DWINScreen {
 private:
     SPIClass* spi;
@@ -27,6 +72,75 @@ private:
     void sendWord(uint16_t data);
     uint8_t receiveByte();
     
+    // Lote de escrituras pendientes; los datos de cada una van en batchData
+    struct BatchWrite {
+        uint16_t address;
+        uint16_t offset;
+        uint8_t len;
+    };
+    BatchWrite batch[DWIN_BATCH_WRITES];
+    uint8_t batchData[DWIN_BATCH_BYTES];
+    uint8_t batchCount = 0;
+    uint16_t batchBytes = 0;
+    bool batching = false;
+    
+    // Lecturas en cola, y las que esperan respuesta agrupadas en tramas
+    struct ReadRequest {
+        uint16_t address;
+        uint8_t words;
+        DWINReadCallback callback;
+        void* ctx;
+    };
+    struct ReadSpan {
+        uint16_t address;
+        uint8_t words;
+        uint8_t first;      // Primera lectura de readsInFlight que cubre
+        uint8_t count;
+    };
+    ReadRequest readQueue[DWIN_READ_QUEUE];
+    ReadRequest readsInFlight[DWIN_READ_QUEUE];
+    ReadSpan readSpans[DWIN_READ_QUEUE];
+    uint8_t readCount = 0;
+    uint8_t inFlightCount = 0;
+    uint8_t spanCount = 0;
+    uint8_t spanNext = 0;       // Primera trama cuya respuesta falta por leer
+    uint8_t readRound = 0;      // Cambia con cada sendReads()
+    bool readsInSync = true;
+    uint32_t readSentMs = 0;
+    
+    // Tabla de sombra: último valor escrito en cada dirección, ordenada por
+    // dirección y sin entradas que se solapen
+    struct ShadowEntry {
+        uint16_t address;
+        uint8_t len;
+        bool dirty;         // Cambió y aún no se ha enviado
+        bool written;       // Cambió después de enviar las lecturas en curso
+        uint8_t value[DWIN_SHADOW_VALUE_BYTES];
+    };
+    ShadowEntry shadow[DWIN_SHADOW_ENTRIES];
+    uint8_t shadowCount = 0;
+    uint8_t shadowDirty = 0;
+    uint8_t shadowEvict = 0;
+    bool shadowEnabled = false;
+    
+    DWINScreenStats stats = {};
+    
+    void write(uint16_t address, const uint8_t* data, uint8_t len);
+    void stageWrite(uint16_t address, const uint8_t* data, uint8_t len);
+    void startWriteFrame(uint16_t address, uint8_t len);
+    void sendWriteFrame(uint16_t address, const uint8_t* data, uint8_t len);
+    void sendBatch();
+    bool shadowWrite(uint16_t address, const uint8_t* data, uint8_t len);
+    uint8_t shadowFind(uint16_t address) const;
+    void shadowOverlap(uint16_t address, uint32_t end, uint8_t& first, uint8_t& last) const;
+    void shadowRemove(uint8_t first, uint8_t last);
+    void shadowRefresh(uint16_t address, const uint16_t* values, uint8_t words);
+    void shadowReadSent();
+    void sendReadRequest(uint16_t address, uint8_t words);
+    bool receiveResponse(uint16_t address, uint16_t* values, uint8_t words);
+    void sendReads();
+    void receiveReads();
+    
 public:
     // Constructor con pines por defecto del VSPI en ESP32
     // CS=5, SCK=18, MOSI=23, MISO=19
@@ -43,6 +157,32 @@ public:
     void writeVariable(uint16_t address, int32_t value);
     void setBacklight(uint8_t brightness);
     uint16_t readVariable(uint16_t address);
+    
+    // Escrituras agrupadas: entre beginBatch() y endBatch() las escrituras se
+    // guardan, y endBatch() envía en una sola trama cada serie de direcciones VP
+    // consecutivas
+    void beginBatch();
+    void endBatch();
+    
+    // Lecturas asíncronas: requestVariable() encola la lectura y poll() la
+    // completa llamando a callback, sin bloquear
+    bool requestVariable(uint16_t address, uint8_t words, DWINReadCallback callback, void* ctx = NULL);
+    void poll();
+    bool readsPending() const;
+    
+    // Tabla de sombra: las escrituras que repiten el último valor escrito en
+    // su dirección se omiten. Las que cambian algo se envían en el momento, o
+    // con endBatch() dentro de un lote; flushShadow() envía lo pendiente antes.
+    // La tabla solo conoce lo que escribe el ESP32 y lo que lee con
+    // readVariable()/requestVariable(): tras cambiar el usuario una variable
+    // desde el panel táctil hay que leerla o llamar a clearShadow() para ella,
+    // o no se reenviará su valor anterior.
+    void enableShadow(bool enable);
+    void flushShadow();
+    void clearShadow();
+    void clearShadow(uint16_t address, uint8_t words);
+    
+    const DWINScreenStats& getStats() const;
 };
 
 #endif
\ No newline at end of file
@@ -1,11 +1,16 @@
 #include <Arduino.h>
 #include <dwin.h>
+#include <dwin_telemetry.h>
+#include <dwin_trace.h>
 
 #include <HardwareSerial.h>
 extern HardwareSerial DWINSerial;
 
-uint8_t dwin_cmd_buffer[256];
-uint8_t cmd_idx = 0;
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#endif
 
 // DWIN T5UIC1 Protocol (Ender 3 V2)
 const uint8_t FRAME_HEADER = 0xAA;
@@ -20,6 +25,7 @@ const uint8_t CMD_DRAW_RECT = 0x05;
 const uint8_t CMD_DRAW_BITMAP = 0x08;
 const uint8_t CMD_MOVE_AREA = 0x09;
 const uint8_t CMD_DRAW_STRING = 0x11;
+const uint8_t CMD_DECOMPRESS_JPEG = 0x25;
 const uint8_t CMD_VIRT_COPY_PASTE = 0x27;
 const uint8_t CMD_BACKLIGHT = 0x30;
 const uint8_t CMD_SET_DIRECTION = 0x34;
@@ -53,21 +59,86 @@ const uint16_t COLOR_BG_BLUE = 0x1125;
 // DWIN LOW-LEVEL COMMUNICATION FUNCTIONS
 //==============================================================================
 
+// Frames are built directly in the transmit arena, one after the other, and the
+// arena is written out in one piece: per frame there is no UART call at all.
+static uint8_t tx_arena[DWIN_TX_ARENA_SIZE];
+static_assert(DWIN_TX_ARENA_SIZE >= DWIN_MAX_FRAME_SIZE, "DWIN_TX_ARENA_SIZE must hold a DWIN_MAX_FRAME_SIZE frame");
+static uint32_t arena_len = 0;       // Bytes of complete frames waiting in the arena
+static uint32_t frame_start = 0;     // Offset of the frame being built
+static uint32_t frame_len = 0;       // Bytes of the frame being built (header included)
+static bool frame_overflow = false;
+static uint8_t batch_depth = 0;
+
+static uint32_t frames_sent = 0;
+static uint32_t frames_dropped = 0;
+static uint32_t arena_writes = 0;
+
+#if defined(ESP32)
+// The flush task (core 0) and direct drawing from loop() (core 1) build frames
+// in the same arena. A frame holds this lock from dwin_start_frame() to
+// dwin_send_frame(), and a batch from dwin_begin_batch() to dwin_end_batch().
+static SemaphoreHandle_t frame_lock = xSemaphoreCreateRecursiveMutex();
+#define DWIN_FRAME_LOCK() xSemaphoreTakeRecursive(frame_lock, portMAX_DELAY)
+#define DWIN_FRAME_UNLOCK() xSemaphoreGiveRecursive(frame_lock)
+#else
+#define DWIN_FRAME_LOCK()
+#define DWIN_FRAME_UNLOCK()
+#endif
+
+static void dwin_tx_enqueue(const uint8_t* data, uint32_t len);
+static void dwin_tx_write(const uint8_t* data, uint32_t len);
+static void dwin_sync_maybe_append();
+
+/**
+ * @brief Makes room for n more bytes of the current frame.
+ * @return false if the frame would exceed DWIN_MAX_FRAME_SIZE.
+ */
+static bool dwin_frame_reserve(uint32_t n) {
+  if (frame_overflow || frame_len + n > DWIN_MAX_FRAME_SIZE - sizeof(FRAME_TAIL)) {
+    frame_overflow = true;
+    return false;
+  }
+  if (frame_start + frame_len + n + sizeof(FRAME_TAIL) > DWIN_TX_ARENA_SIZE) {
+    // Send the complete frames and move the partial one to the front.
+    dwin_flush_frames();
+    memmove(tx_arena, &tx_arena[frame_start], frame_len);
+    frame_start = 0;
+  }
+  return true;
+}
+
 /**
  * @brief Starts a new DWIN command frame by adding the header.
  */
 void dwin_start_frame() {
-  cmd_idx = 0;
-  dwin_cmd_buffer[cmd_idx++] = FRAME_HEADER;
+  DWIN_FRAME_LOCK();
+  frame_start = arena_len;
+  frame_len = 0;
+  frame_overflow = false;
+  dwin_add_byte(FRAME_HEADER);
 }
 
 /**
- * @brief Adds a single byte to the current DWIN command buffer.
+ * @brief Adds a single byte to the current DWIN command frame.
  * @param value The byte to add.
+ * @note Bytes beyond DWIN_MAX_FRAME_SIZE mark the frame as overflowed and
+ * dwin_send_frame() then drops it instead of sending a truncated command.
  */
 void dwin_add_byte(uint8_t value) {
-  if (cmd_idx < sizeof(dwin_cmd_buffer)) {
-    dwin_cmd_buffer[cmd_idx++] = value;
+  if (dwin_frame_reserve(1)) {
+    tx_arena[frame_start + frame_len++] = value;
+  }
+}
+
+/**
+ * @brief Adds a block of raw bytes to the current DWIN command frame.
+ * @param data The bytes to add.
+ * @param len Number of bytes.
+ */
+void dwin_add_bytes(const uint8_t* data, uint32_t len) {
+  if (dwin_frame_reserve(len)) {
+    memcpy(&tx_arena[frame_start + frame_len], data, len);
+    frame_len += len;
   }
 }
 
@@ -76,8 +147,10 @@ void dwin_add_byte(uint8_t value) {
  * @param value The 16-bit value to add.
  */
 void dwin_add_word(uint16_t value) {
-  dwin_add_byte((value >> 8) & 0xFF);
-  dwin_add_byte(value & 0xFF);
+  if (dwin_frame_reserve(2)) {
+    tx_arena[frame_start + frame_len++] = (value >> 8) & 0xFF;
+    tx_arena[frame_start + frame_len++] = value & 0xFF;
+  }
 }
 
 /**
@@ -85,18 +158,451 @@ void dwin_add_word(uint16_t value) {
  * @param str The C-style string to add.
  */
 void dwin_add_string(const char* str) {
-  while (*str) {
-    dwin_add_byte(*str++);
+  dwin_add_bytes((const uint8_t*)str, strlen(str));
+}
+
+/**
+ * @brief Bytes that can still be added to the current frame.
+ */
+uint32_t dwin_frame_space() {
+  return frame_overflow ? 0 : DWIN_MAX_FRAME_SIZE - sizeof(FRAME_TAIL) - frame_len;
+}
+
+/**
+ * @brief Finalizes the DWIN command frame and sends it over UART.
+ * @return false if the frame overflowed DWIN_MAX_FRAME_SIZE and was dropped.
+ * @note Inside dwin_begin_batch()/dwin_end_batch() the frame stays in the arena
+ * and goes out with its neighbours in a single write.
+ */
+bool dwin_send_frame() {
+  if (frame_overflow) {
+    frames_dropped++;
+    frame_len = 0;
+    DWIN_FRAME_UNLOCK();
+    return false;
+  }
+  memcpy(&tx_arena[frame_start + frame_len], FRAME_TAIL, sizeof(FRAME_TAIL));
+  arena_len = frame_start + frame_len + sizeof(FRAME_TAIL);
+  dwin_trace_frame(&tx_arena[frame_start], frame_len + sizeof(FRAME_TAIL));
+  frame_len = 0;
+  frames_sent++;
+  dwin_telemetry_frame();
+  if (batch_depth == 0) {
+    dwin_flush_frames();
+  }
+  DWIN_FRAME_UNLOCK();
+  return true;
+}
+
+/**
+ * @brief Writes every complete frame in the arena with a single UART write.
+ * @note Once dwin_tx_begin() has run, the frames are only queued and this
+ * returns immediately; frames then go out back-to-back, as Marlin sends them,
+ * instead of with a fixed 1 ms gap.
+ */
+void dwin_flush_frames() {
+  DWIN_FRAME_LOCK();
+  if (arena_len == 0) {
+    DWIN_FRAME_UNLOCK();
+    return;
+  }
+  uint32_t start = dwin_telemetry_ticks();
+  dwin_sync_maybe_append();
+  arena_writes++;
+  if (dwin_tx_async()) {
+    dwin_tx_enqueue(tx_arena, arena_len);
+  } else {
+    dwin_tx_write(tx_arena, arena_len);
+  }
+  dwin_telemetry_write(arena_len, start);
+  arena_len = 0;
+  DWIN_FRAME_UNLOCK();
+}
+
+/**
+ * @brief Starts collecting frames in the arena instead of writing each one.
+ * @note Batches nest; the arena is written when the outermost batch ends or fills up.
+ * Other tasks wait to build frames until the batch ends.
+ */
+void dwin_begin_batch() {
+  DWIN_FRAME_LOCK();
+  batch_depth++;
+}
+
+/**
+ * @brief Ends a batch started with dwin_begin_batch().
+ */
+void dwin_end_batch() {
+  if (batch_depth == 0) return;
+  if (--batch_depth == 0) {
+    dwin_flush_frames();
+  }
+  DWIN_FRAME_UNLOCK();
+}
+
+//==============================================================================
+// DWIN ASYNCHRONOUS TRANSMIT
+//==============================================================================
+
+// Single producer (the drawing code) and single consumer (the TX task). Head and
+// tail are free-running byte counters; the ring index is the counter modulo size.
+static volatile uint32_t tx_head = 0;
+static volatile uint32_t tx_tail = 0;
+static uint32_t tx_high_water = 0;
+static uint32_t tx_stalls = 0;
+
+// Callback to run once tx_tail reaches tx_drained_mark.
+static void (*volatile tx_drained_cb)(void* arg) = NULL;
+static void* volatile tx_drained_arg = NULL;
+static volatile uint32_t tx_drained_mark = 0;
+
+// Sync points: tx_head positions just past each handshake frame sent and not
+// yet answered, oldest at sync_tail. The panel has read every byte before
+// acked_pos.
+static const uint8_t SYNC_FRAME[] = {0xAA, 0x00, 0xCC, 0x33, 0xC3, 0x3C};
+static volatile uint32_t sync_pos[DWIN_SYNC_PENDING];
+static volatile uint8_t sync_head = 0;
+static volatile uint8_t sync_tail = 0;
+static uint32_t last_sync_pos = 0;
+static volatile uint32_t acked_pos = 0;
+static volatile bool panel_answering = false;
+
+// Response parser: bytes of the frame being received, header included.
+static uint8_t rx_frame[DWIN_RX_MAX_FRAME];
+static uint8_t rx_len = 0;
+static void (*rx_handler)(const uint8_t* payload, uint8_t len) = NULL;
+static dwin_rx_stats_t rx_stats;
+
+static void dwin_tx_gate(uint32_t end);
+static void dwin_rx_parse();
+
+#if defined(ESP32)
+static uint8_t tx_ring[DWIN_TX_RING_SIZE];
+static_assert((DWIN_TX_RING_SIZE & (DWIN_TX_RING_SIZE - 1)) == 0, "DWIN_TX_RING_SIZE must be a power of two");
+// dwin_tx_enqueue() waits for room for a whole arena, sync frames included.
+static_assert(DWIN_TX_RING_SIZE >= DWIN_TX_ARENA_SIZE + sizeof(SYNC_FRAME),
+              "DWIN_TX_RING_SIZE must hold a full DWIN_TX_ARENA_SIZE write");
+static TaskHandle_t tx_task = NULL;
+static portMUX_TYPE tx_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Bytes written to the UART per call, so the tail advances while a large frame drains.
+#define DWIN_TX_CHUNK 128
+
+// Sync points are added by the task that flushes and answered on the transmit
+// task; both change sync_tail, panel_answering and rx_stats.timeouts.
+#define DWIN_SYNC_LOCK() portENTER_CRITICAL(&tx_mux)
+#define DWIN_SYNC_UNLOCK() portEXIT_CRITICAL(&tx_mux)
+
+/**
+ * @brief Drains the ring into the UART and runs the drained callback.
+ */
+static void dwin_tx_task(void* param) {
+  for (;;) {
+    // While sync points are unanswered, look for the answers every tick.
+    ulTaskNotifyTake(pdTRUE, sync_tail != sync_head ? 1 : portMAX_DELAY);
+    dwin_rx_parse();
+    while (tx_tail != tx_head) {
+      uint32_t idx = tx_tail & (DWIN_TX_RING_SIZE - 1);
+      uint32_t len = min(tx_head - tx_tail, (uint32_t)(DWIN_TX_RING_SIZE - idx));
+      len = min(len, (uint32_t)DWIN_TX_CHUNK);
+      dwin_tx_gate(tx_tail + len);
+      DWINSerial.write(&tx_ring[idx], len);
+      tx_tail += len;
+      dwin_rx_parse();
+
+      void (*callback)(void*) = NULL;
+      void* arg = NULL;
+      portENTER_CRITICAL(&tx_mux);
+      if (tx_drained_cb && (int32_t)(tx_tail - tx_drained_mark) >= 0) {
+        callback = tx_drained_cb;
+        arg = tx_drained_arg;
+        tx_drained_cb = NULL;
+      }
+      portEXIT_CRITICAL(&tx_mux);
+      if (callback) callback(arg);
+    }
+  }
+}
+#else
+#define DWIN_SYNC_LOCK()
+#define DWIN_SYNC_UNLOCK()
+#endif
+
+/**
+ * @brief Appends bytes to the transmit ring, waiting while it is full.
+ */
+static void dwin_tx_enqueue(const uint8_t* data, uint32_t len) {
+#if defined(ESP32)
+  while (DWIN_TX_RING_SIZE - (tx_head - tx_tail) < len) {
+    tx_stalls++;
+    xTaskNotifyGive(tx_task);
+    vTaskDelay(1);
+  }
+  uint32_t idx = tx_head & (DWIN_TX_RING_SIZE - 1);
+  uint32_t first = min(len, (uint32_t)(DWIN_TX_RING_SIZE - idx));
+  memcpy(&tx_ring[idx], data, first);
+  memcpy(tx_ring, data + first, len - first);
+  tx_head += len;
+  tx_high_water = max(tx_high_water, (uint32_t)(tx_head - tx_tail));
+  xTaskNotifyGive(tx_task);
+#endif
+}
+
+/**
+ * @brief Writes complete frames to the UART from the calling task (no transmit task).
+ * @note Paced by the panel's answers once it has given one, else by a fixed
+ * 1 ms pause per write.
+ */
+static void dwin_tx_write(const uint8_t* data, uint32_t len) {
+  dwin_tx_gate(tx_head + len);
+  DWINSerial.write(data, len);
+  tx_head += len;
+  tx_tail = tx_head;
+  dwin_rx_parse();
+  if (!panel_answering) delay(1);
+}
+
+/**
+ * @brief Starts the transmit task; from then on dwin_send_frame() only queues frames.
+ * @return true if asynchronous transmit is available (ESP32 only).
+ * @note Call after DWINSerial.begin(). The task runs on core 0, next to the
+ * UART driver, while LVGL keeps rendering on the Arduino loop core.
+ */
+bool dwin_tx_begin() {
+#if defined(ESP32)
+  if (!tx_task) {
+    xTaskCreatePinnedToCore(dwin_tx_task, "dwin_tx", 2048, NULL, 2, &tx_task, 0);
+  }
+  return tx_task != NULL;
+#else
+  return false;
+#endif
+}
+
+/**
+ * @brief Tells whether frames are queued (true) or written synchronously (false).
+ */
+bool dwin_tx_async() {
+#if defined(ESP32)
+  return tx_task != NULL;
+#else
+  return false;
+#endif
+}
+
+/**
+ * @brief Runs a callback once every byte queued so far has been handed to the UART.
+ * @param callback Function to call; it may run on the TX task.
+ * @param arg Argument passed to the callback.
+ * @note Only one callback can be pending. Without the TX task it runs immediately.
+ */
+void dwin_tx_when_drained(void (*callback)(void* arg), void* arg) {
+#if defined(ESP32)
+  if (tx_task) {
+    bool drained;
+    portENTER_CRITICAL(&tx_mux);
+    drained = tx_tail == tx_head;
+    if (!drained) {
+      tx_drained_arg = arg;
+      tx_drained_mark = tx_head;
+      tx_drained_cb = callback;
+    }
+    portEXIT_CRITICAL(&tx_mux);
+    if (!drained) return;
+  }
+#endif
+  callback(arg);
+}
+
+/**
+ * @brief Copies the transmit counters.
+ * @param stats Destination.
+ */
+void dwin_tx_get_stats(dwin_tx_stats_t* stats) {
+  stats->queued = tx_head;
+  stats->sent = tx_tail;
+  stats->high_water = tx_high_water;
+  stats->stalls = tx_stalls;
+  stats->frames = frames_sent;
+  stats->dropped = frames_dropped;
+  stats->writes = arena_writes;
+}
+
+//==============================================================================
+// DWIN RESPONSES AND FLOW CONTROL
+//==============================================================================
+
+/**
+ * @brief Appends a sync point (handshake frame) to the arena.
+ * @return false if the arena or the list of pending sync points is full.
+ * @note Only between frames: the arena must not hold a partial frame.
+ */
+static bool dwin_sync_append() {
+  if (arena_len + sizeof(SYNC_FRAME) > DWIN_TX_ARENA_SIZE) return false;
+  DWIN_SYNC_LOCK();
+  if ((uint8_t)(sync_head - sync_tail) >= DWIN_SYNC_PENDING) {
+    if (panel_answering) {
+      DWIN_SYNC_UNLOCK();
+      return false;
+    }
+    // Nobody is answering (RX not wired?): stop waiting for these.
+    rx_stats.timeouts += (uint8_t)(sync_head - sync_tail);
+    sync_tail = sync_head;
+  }
+  memcpy(&tx_arena[arena_len], SYNC_FRAME, sizeof(SYNC_FRAME));
+  arena_len += sizeof(SYNC_FRAME);
+  last_sync_pos = tx_head + arena_len;
+  sync_pos[sync_head & (DWIN_SYNC_PENDING - 1)] = last_sync_pos;
+  sync_head = sync_head + 1;
+  rx_stats.syncs++;
+  DWIN_SYNC_UNLOCK();
+  dwin_trace_frame(SYNC_FRAME, sizeof(SYNC_FRAME));
+  return true;
+}
+
+/**
+ * @brief Adds a sync point to the arena being written out once
+ * DWIN_SYNC_INTERVAL bytes have gone out since the last one.
+ */
+static void dwin_sync_maybe_append() {
+  if (DWIN_SYNC_INTERVAL == 0 || frame_len != 0) return;
+  if (tx_head + arena_len - last_sync_pos >= DWIN_SYNC_INTERVAL) dwin_sync_append();
+}
+
+/**
+ * @brief Holds a write back while it would put more than DWIN_TX_WINDOW bytes
+ * past the last sync point the panel answered.
+ * @param end tx_head position just past the bytes about to be written.
+ * @note Only waits for sync points already sent. Gives up, and falls back to
+ * fixed pacing, if the panel does not answer within DWIN_SYNC_TIMEOUT_MS.
+ */
+static void dwin_tx_gate(uint32_t end) {
+  if (!panel_answering) return;
+  uint32_t start = micros();
+  bool waited = false;
+  for (;;) {
+    dwin_rx_parse();
+    DWIN_SYNC_LOCK();
+    bool open = (int32_t)(end - acked_pos) <= DWIN_TX_WINDOW || sync_tail == sync_head ||
+                (int32_t)(tx_tail - sync_pos[sync_tail & (DWIN_SYNC_PENDING - 1)]) < 0;
+    bool timeout = !open && micros() - start >= DWIN_SYNC_TIMEOUT_MS * 1000UL;
+    if (timeout) {
+      rx_stats.timeouts += (uint8_t)(sync_head - sync_tail);
+      sync_tail = sync_head;
+      panel_answering = false;
+    }
+    DWIN_SYNC_UNLOCK();
+    if (open || timeout) break;
+    if (!waited) {
+      rx_stats.waits++;
+      waited = true;
+    }
+#if defined(ESP32)
+    vTaskDelay(1);
+#else
+    delayMicroseconds(100);
+#endif
+  }
+  if (waited) rx_stats.wait_us += micros() - start;
+}
+
+static void dwin_rx_frame(const uint8_t* payload, uint8_t len) {
+  rx_stats.frames++;
+  if (len == 3 && payload[0] == CMD_HANDSHAKE && payload[1] == 'O' && payload[2] == 'K') {
+    DWIN_SYNC_LOCK();
+    rx_stats.acks++;
+    if (sync_tail != sync_head) {
+      acked_pos = sync_pos[sync_tail & (DWIN_SYNC_PENDING - 1)];
+      sync_tail = sync_tail + 1;
+      panel_answering = true;
+    }
+    DWIN_SYNC_UNLOCK();
+    return;
+  }
+  if (rx_handler) rx_handler(payload, len);
+}
+
+/**
+ * @brief Feeds the bytes the panel has sent into the response parser; never waits.
+ * @note Runs on the task that writes to the UART, so the parser has a single user.
+ */
+static void dwin_rx_parse() {
+  while (DWINSerial.available() > 0) {
+    int c = DWINSerial.read();
+    if (c < 0) break;
+    rx_stats.bytes++;
+    if (rx_len == DWIN_RX_MAX_FRAME) {
+      rx_stats.garbage += rx_len;
+      rx_len = 0;
+    }
+    if (rx_len == 0 && c != FRAME_HEADER) {
+      rx_stats.garbage++;
+      continue;
+    }
+    rx_frame[rx_len++] = (uint8_t)c;
+    if (rx_len >= 1 + sizeof(FRAME_TAIL) &&
+        memcmp(&rx_frame[rx_len - sizeof(FRAME_TAIL)], FRAME_TAIL, sizeof(FRAME_TAIL)) == 0) {
+      dwin_rx_frame(&rx_frame[1], rx_len - 1 - sizeof(FRAME_TAIL));
+      rx_len = 0;
+    }
   }
 }
 
 /**
- * @brief Finalizes and sends the DWIN command frame over UART.
+ * @brief Processes the panel's responses received so far; never waits.
+ * @note With the transmit task running, the task does it.
  */
-void dwin_send_frame() {
-  DWINSerial.write(dwin_cmd_buffer, cmd_idx);
-  DWINSerial.write(FRAME_TAIL, 4);
-  delay(1);
+void dwin_rx_poll() {
+#if defined(ESP32)
+  if (tx_task) {
+    xTaskNotifyGive(tx_task);
+    return;
+  }
+#endif
+  dwin_rx_parse();
+}
+
+/**
+ * @brief Sets a function called with every response other than a handshake
+ * answer (payload between the 0xAA header and the tail).
+ * @note It runs on the task that writes to the UART.
+ */
+void dwin_rx_set_handler(void (*handler)(const uint8_t* payload, uint8_t len)) {
+  rx_handler = handler;
+}
+
+/**
+ * @brief Sends a handshake and waits for the panel to answer it.
+ * @param timeout_ms Longest wait.
+ * @return true if the panel answered; it then also paces the transmission.
+ */
+bool dwin_handshake(uint32_t timeout_ms) {
+  uint32_t acks = rx_stats.acks;
+  DWIN_FRAME_LOCK();
+  if (frame_len != 0 || !dwin_sync_append()) {
+    DWIN_FRAME_UNLOCK();
+    return false;
+  }
+  dwin_flush_frames();
+  DWIN_FRAME_UNLOCK();
+  uint32_t start = millis();
+  while (rx_stats.acks == acks) {
+    if (millis() - start >= timeout_ms) return false;
+    dwin_rx_poll();
+    delay(1);
+  }
+  return true;
+}
+
+/**
+ * @brief Tells whether the panel answers sync points, i.e. paces the transmission.
+ */
+bool dwin_panel_answering() {
+  return panel_answering;
+}
+
+void dwin_rx_get_stats(dwin_rx_stats_t* stats) {
+  *stats = rx_stats;
 }
 
 //==============================================================================
@@ -136,13 +642,120 @@ void dwin_clear_screen(uint16_t color) {
 }
 
 /**
- * @brief Converts a 32-bit LVGL color to DWIN's 16-bit RGB565 format.
- * @param lvgl_color The LVGL color structure.
- * @return The 16-bit RGB565 color word.
+ * @brief Draws a rectangle outline or fill (CMD_DRAW_RECT).
+ * @param mode 0x00 = frame, 0x01 = fill, 0x02 = XOR fill.
+ * @param color The RGB565 color.
+ * @param xs Upper-left x-coordinate.
+ * @param ys Upper-left y-coordinate.
+ * @param xe Lower-right x-coordinate (inclusive).
+ * @param ye Lower-right y-coordinate (inclusive).
  */
-uint16_t lvgl_to_dwin_color(lv_color_t lvgl_color) {
-  uint16_t r5 = (lvgl_color.ch.red >> 3) & 0x1F;
-  uint16_t g6 = (lvgl_color.ch.green >> 2) & 0x3F;
-  uint16_t b5 = (lvgl_color.ch.blue >> 3) & 0x1F;
-  return (r5 << 11) | (g6 << 5) | b5;
-}
\ No newline at end of file
+void dwin_draw_rect(uint8_t mode, uint16_t color, uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye) {
+  dwin_start_frame();
+  dwin_add_byte(CMD_DRAW_RECT);
+  dwin_add_byte(mode);
+  dwin_add_word(color);
+  dwin_add_word(xs);
+  dwin_add_word(ys);
+  dwin_add_word(xe);
+  dwin_add_word(ye);
+  dwin_send_frame();
+}
+
+/**
+ * @brief Draws a straight line segment between two points (CMD_DRAW_LINE).
+ * @param color The RGB565 color.
+ * @param xs Start x-coordinate.
+ * @param ys Start y-coordinate.
+ * @param xe End x-coordinate (inclusive).
+ * @param ye End y-coordinate (inclusive).
+ */
+void dwin_draw_line(uint16_t color, uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye) {
+  dwin_start_frame();
+  dwin_add_byte(CMD_DRAW_LINE);
+  dwin_add_word(color);
+  dwin_add_word(xs);
+  dwin_add_word(ys);
+  dwin_add_word(xe);
+  dwin_add_word(ye);
+  dwin_send_frame();
+}
+
+/**
+ * @brief Shifts a screen region on the panel itself (CMD_MOVE_AREA).
+ * @param mode 0x00 = circular shift, 0x01 = translation (vacated pixels get color).
+ * @param dir 0x00 = left, 0x01 = right, 0x02 = up, 0x03 = down.
+ * @param dis Distance in pixels.
+ * @param color The RGB565 color of the vacated pixels in translation mode.
+ * @param xs Upper-left x-coordinate of the region.
+ * @param ys Upper-left y-coordinate of the region.
+ * @param xe Lower-right x-coordinate (inclusive).
+ * @param ye Lower-right y-coordinate (inclusive).
+ */
+void dwin_move_area(uint8_t mode, uint8_t dir, uint16_t dis, uint16_t color,
+                    uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye) {
+  dwin_start_frame();
+  dwin_add_byte(CMD_MOVE_AREA);
+  dwin_add_byte((mode << 7) | dir);
+  dwin_add_word(dis);
+  dwin_add_word(color);
+  dwin_add_word(xs);
+  dwin_add_word(ys);
+  dwin_add_word(xe);
+  dwin_add_word(ye);
+  dwin_send_frame();
+}
+
+/**
+ * @brief Decodes a JPEG picture stored in the panel's flash into a virtual display area.
+ * @param page Virtual display area (VRAM page) that receives the picture.
+ * @param picture_id Picture number in the panel's flash.
+ */
+void dwin_jpeg_cache(uint8_t page, uint8_t picture_id) {
+  dwin_start_frame();
+  dwin_add_byte(CMD_DECOMPRESS_JPEG);
+  dwin_add_byte(page);
+  dwin_add_byte(picture_id);
+  dwin_send_frame();
+}
+
+/**
+ * @brief Copies a rectangle of a virtual display area onto the screen (CMD_VIRT_COPY_PASTE).
+ * @param page Source virtual display area (VRAM page).
+ * @param xs Source upper-left x-coordinate.
+ * @param ys Source upper-left y-coordinate.
+ * @param xe Source lower-right x-coordinate (inclusive).
+ * @param ye Source lower-right y-coordinate (inclusive).
+ * @param x Destination upper-left x-coordinate on screen.
+ * @param y Destination upper-left y-coordinate on screen.
+ */
+void dwin_virt_copy_paste(uint8_t page, uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye,
+                          uint16_t x, uint16_t y) {
+  dwin_start_frame();
+  dwin_add_byte(CMD_VIRT_COPY_PASTE);
+  dwin_add_byte(0x80 | page);   // Bit 7: copy the background too (no color filtering)
+  dwin_add_word(xs);
+  dwin_add_word(ys);
+  dwin_add_word(xe);
+  dwin_add_word(ye);
+  dwin_add_word(x);
+  dwin_add_word(y);
+  dwin_send_frame();
+}
+
+/**
+ * @brief Sets a single 1x1 pixel (CMD_SET_POINT).
+ * @param color The RGB565 color.
+ * @param x The x-coordinate.
+ * @param y The y-coordinate.
+ */
+void dwin_draw_point(uint16_t color, uint16_t x, uint16_t y) {
+  dwin_start_frame();
+  dwin_add_byte(CMD_SET_POINT);
+  dwin_add_word(color);
+  dwin_add_byte(0x01); // Nx: 1 pixel width
+  dwin_add_byte(0x01); // Ny: 1 pixel height
+  dwin_add_word(x);
+  dwin_add_word(y);
+  dwin_send_frame();
+}
@@ -0,0 +1,237 @@
+/**
+ * @file dwin_atlas.cpp
+ * @brief Registry of sprites resident in the panel's virtual display areas.
+ */
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <dwin.h>
+#include <dwin_atlas.h>
+#include <dwin_tiles.h>
+
+static dwin_sprite_t sprites[DWIN_ATLAS_MAX_SPRITES];
+static uint8_t sprite_count = 0;
+
+// Picture decoded into each VRAM page. Pages loaded with dwin_atlas_load()
+// are pinned; the others hold on-demand pictures, replaced least recently drawn first.
+static bool page_loaded[DWIN_VRAM_PAGES];
+static bool page_pinned[DWIN_VRAM_PAGES];
+static uint8_t page_picture[DWIN_VRAM_PAGES];
+static uint32_t page_last_used[DWIN_VRAM_PAGES];
+static uint32_t use_clock = 0;
+
+static dwin_atlas_stats_t atlas_stats;
+
+/**
+ * @brief Reports the size of sprite image sources to LVGL (lv_img widgets need it).
+ */
+static lv_res_t dwin_atlas_decoder_info(lv_img_decoder_t* decoder, const void* src, lv_img_header_t* header) {
+  const dwin_sprite_t* sprite = dwin_atlas_from_src(src);
+  if (!sprite) return LV_RES_INV;
+  *header = sprite->img.header;
+  return LV_RES_OK;
+}
+
+/**
+ * @brief Registers the image decoder for sprite sources; call after lv_init().
+ * @note Sprites are drawn by the draw context's draw_img hook; the decoder only
+ * answers size queries.
+ */
+void dwin_atlas_init() {
+  lv_img_decoder_t* decoder = lv_img_decoder_create();
+  if (decoder) lv_img_decoder_set_info_cb(decoder, dwin_atlas_decoder_info);
+}
+
+/**
+ * @brief Decodes a picture from the panel's flash into a VRAM page.
+ * @param page VRAM page (0 .. DWIN_VRAM_PAGES-1).
+ * @param picture_id Picture number in the panel's flash.
+ * @return false for an invalid page.
+ * @note Sprites and tiles registered on the page for another picture are
+ * forgotten; their ids and image sources stop drawing anything. The page is
+ * pinned: on-demand pictures are no longer decoded into it.
+ */
+bool dwin_atlas_load(uint8_t page, uint8_t picture_id) {
+  if (page >= DWIN_VRAM_PAGES) return false;
+
+  if (page_loaded[page] && page_picture[page] != picture_id) {
+    for (uint8_t i = 0; i < sprite_count; i++) {
+      if (sprites[i].page == page) sprites[i].name = NULL;
+    }
+    dwin_tiles_forget_page(page);
+  }
+
+  dwin_jpeg_cache(page, picture_id);
+  page_loaded[page] = true;
+  page_pinned[page] = true;
+  page_picture[page] = picture_id;
+  atlas_stats.loads++;
+  return true;
+}
+
+/**
+ * @brief Finds or decodes an on-demand picture in VRAM.
+ * @return Page holding the picture, or -1 if every page is pinned.
+ */
+static int dwin_atlas_page_for(uint8_t picture_id) {
+  int page = -1;
+  for (uint8_t p = 0; p < DWIN_VRAM_PAGES; p++) {
+    if (page_loaded[p] && page_picture[p] == picture_id) {
+      page = p;
+      break;
+    }
+  }
+
+  if (page < 0) {
+    for (uint8_t p = 0; p < DWIN_VRAM_PAGES; p++) {
+      if (page_pinned[p]) continue;
+      if (page < 0 || !page_loaded[p] || (page_loaded[page] && page_last_used[p] < page_last_used[page])) page = p;
+    }
+    if (page < 0) return -1;
+    if (page_loaded[page]) atlas_stats.evictions++;
+    dwin_tiles_forget_page(page);
+    dwin_jpeg_cache(page, picture_id);
+    page_loaded[page] = true;
+    page_picture[page] = picture_id;
+    atlas_stats.loads++;
+  }
+
+  page_last_used[page] = ++use_clock;
+  return page;
+}
+
+/**
+ * @brief Registers a sprite: a rectangle of a loaded VRAM page.
+ * @param page VRAM page the sprite lives in; must have been loaded.
+ * @param name Name to look the sprite up by; the string must stay valid.
+ * @param x Left edge in the page.
+ * @param y Top edge in the page.
+ * @param w Width in pixels.
+ * @param h Height in pixels.
+ * @return Sprite id, or -1 if the registry is full or the sprite does not fit.
+ * @note Ids are never reused, so DWIN_ATLAS_MAX_SPRITES bounds the sprites
+ * registered since boot, forgotten ones included.
+ */
+int dwin_atlas_add(uint8_t page, const char* name, uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+  if (page != DWIN_ATLAS_ON_DEMAND && (page >= DWIN_VRAM_PAGES || !page_loaded[page])) return -1;
+  if (name == NULL || w == 0 || h == 0 || x + w > DWIN_WIDTH || y + h > DWIN_HEIGHT) return -1;
+
+  // Slots of forgotten sprites are never reused: an lv_img may still point at
+  // their image source, which must keep drawing nothing.
+  if (sprite_count >= DWIN_ATLAS_MAX_SPRITES) return -1;
+  int id = sprite_count++;
+
+  dwin_sprite_t* sprite = &sprites[id];
+  memset(sprite, 0, sizeof(*sprite));
+  sprite->name = name;
+  sprite->page = page;
+  sprite->area.x1 = x;
+  sprite->area.y1 = y;
+  sprite->area.x2 = x + w - 1;
+  sprite->area.y2 = y + h - 1;
+  sprite->img.header.cf = LV_IMG_CF_USER_ENCODED_0;
+  sprite->img.header.w = w;
+  sprite->img.header.h = h;
+  return id;
+}
+
+/**
+ * @brief Registers a region of a JPEG picture in the panel's flash as a sprite.
+ * @param picture_id Picture number in the panel's flash.
+ * @param name Name to look the sprite up by; the string must stay valid.
+ * @param x Left edge in the picture.
+ * @param y Top edge in the picture.
+ * @param w Width in pixels (DWIN_WIDTH for a full-screen picture).
+ * @param h Height in pixels.
+ * @return Sprite id, or -1 if the registry is full or the region does not fit.
+ * @note The picture is decoded into VRAM when the sprite is first drawn. Like
+ * any sprite it is drawn on top of the flushed pixels, so nothing LVGL draws
+ * over it stays visible.
+ */
+int dwin_atlas_add_picture(uint8_t picture_id, const char* name, uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+  int id = dwin_atlas_add(DWIN_ATLAS_ON_DEMAND, name, x, y, w, h);
+  if (id >= 0) sprites[id].picture = picture_id;
+  return id;
+}
+
+/**
+ * @brief Looks a sprite up by name.
+ * @return Sprite id, or -1 if it is not registered.
+ */
+int dwin_atlas_find(const char* name) {
+  for (uint8_t i = 0; i < sprite_count; i++) {
+    if (sprites[i].name && strcmp(sprites[i].name, name) == 0) return i;
+  }
+  return -1;
+}
+
+const dwin_sprite_t* dwin_atlas_get(int sprite) {
+  return sprite >= 0 && sprite < sprite_count && sprites[sprite].name ? &sprites[sprite] : NULL;
+}
+
+/**
+ * @brief LVGL image source for a sprite, for lv_img_set_src().
+ */
+const void* dwin_atlas_img_src(int sprite) {
+  const dwin_sprite_t* s = dwin_atlas_get(sprite);
+  return s ? &s->img : NULL;
+}
+
+/**
+ * @brief Finds the sprite an LVGL image source belongs to.
+ * @return The sprite, or NULL for any other image source.
+ */
+const dwin_sprite_t* dwin_atlas_from_src(const void* src) {
+  for (uint8_t i = 0; i < sprite_count; i++) {
+    if (src == &sprites[i].img) return sprites[i].name ? &sprites[i] : NULL;
+  }
+  return NULL;
+}
+
+/**
+ * @brief Draws a sprite directly, outside LVGL.
+ * @return false for an unknown sprite, or a picture that could not be decoded.
+ */
+bool dwin_atlas_draw(int sprite, uint16_t x, uint16_t y) {
+  const dwin_sprite_t* s = dwin_atlas_get(sprite);
+  return s && dwin_atlas_blit(s, &s->area, x, y);
+}
+
+/**
+ * @brief Shows a full-screen JPEG picture from the panel's flash, outside LVGL
+ * (e.g. a splash screen before the UI starts).
+ * @return false if no VRAM page is free to decode it.
+ */
+bool dwin_atlas_show_picture(uint8_t picture_id) {
+  int page = dwin_atlas_page_for(picture_id);
+  if (page < 0) return false;
+  dwin_virt_copy_paste(page, 0, 0, DWIN_WIDTH - 1, DWIN_HEIGHT - 1, 0, 0);
+  atlas_stats.draws++;
+  atlas_stats.draw_px += (uint32_t)DWIN_WIDTH * DWIN_HEIGHT;
+  dwin_shadow_invalidate();
+  return true;
+}
+
+/**
+ * @brief Copies part of a sprite onto the screen.
+ * @param sprite The sprite.
+ * @param part Area to copy, in VRAM page coordinates, inside the sprite.
+ * @param x Destination left edge on screen.
+ * @param y Destination top edge on screen.
+ * @return false if the sprite's picture could not be decoded into VRAM.
+ */
+bool dwin_atlas_blit(const dwin_sprite_t* sprite, const lv_area_t* part, uint16_t x, uint16_t y) {
+  int page = sprite->page;
+  if (page == DWIN_ATLAS_ON_DEMAND) {
+    page = dwin_atlas_page_for(sprite->picture);
+    if (page < 0) return false;
+  }
+  dwin_virt_copy_paste(page, part->x1, part->y1, part->x2, part->y2, x, y);
+  atlas_stats.draws++;
+  atlas_stats.draw_px += lv_area_get_size(part);
+  return true;
+}
+
+const dwin_atlas_stats_t* dwin_atlas_get_stats() {
+  return &atlas_stats;
+}
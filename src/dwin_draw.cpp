@@ -0,0 +1,499 @@
+/**
+ * @file dwin_draw.cpp
+ * @brief LVGL draw hooks that let the panel draw text, fills, lines and sprites natively.
+ */
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <dwin.h>
+#include <dwin_draw.h>
+#include <dwin_atlas.h>
+#include <dwin_encoder.h>
+
+static dwin_draw_stats_t draw_stats;
+
+//==============================================================================
+// NATIVE FONTS
+//==============================================================================
+
+typedef struct {
+  uint8_t id;       // FONT_* code sent with CMD_DRAW_STRING
+  uint8_t width;
+  uint8_t height;
+} dwin_font_dsc_t;
+
+static const dwin_font_dsc_t font_dsc[10] = {
+  {FONT_6x12, 6, 12},   {FONT_8x16, 8, 16},   {FONT_10x20, 10, 20}, {FONT_12x24, 12, 24},
+  {FONT_14x28, 14, 28}, {FONT_16x32, 16, 32}, {FONT_20x40, 20, 40}, {FONT_24x48, 24, 48},
+  {FONT_28x56, 28, 56}, {FONT_32x64, 32, 64},
+};
+
+/**
+ * @brief Fixed-width metrics of a panel font; the glyph cell is the whole line.
+ */
+static bool dwin_font_get_glyph_dsc(const lv_font_t* font, lv_font_glyph_dsc_t* dsc,
+                                    uint32_t letter, uint32_t letter_next) {
+  const dwin_font_dsc_t* f = (const dwin_font_dsc_t*)font->dsc;
+  if (letter < 0x20 || letter > 0x7E) return false;
+
+  dsc->adv_w = f->width;
+  dsc->box_w = f->width;
+  dsc->box_h = f->height;
+  dsc->ofs_x = 0;
+  dsc->ofs_y = 0;
+  dsc->bpp = 1;
+  return true;
+}
+
+/**
+ * @brief Panel fonts have no bitmaps on this side; the glyphs live in the panel's ROM.
+ */
+static const uint8_t* dwin_font_get_glyph_bitmap(const lv_font_t* font, uint32_t letter) {
+  return NULL;
+}
+
+#define DWIN_FONT(name, n) \
+  const lv_font_t name = {dwin_font_get_glyph_dsc, dwin_font_get_glyph_bitmap, \
+                          font_dsc[n].height, 0, 0, 0, 0, &font_dsc[n]}
+
+DWIN_FONT(dwin_font_6x12, 0);
+DWIN_FONT(dwin_font_8x16, 1);
+DWIN_FONT(dwin_font_10x20, 2);
+DWIN_FONT(dwin_font_12x24, 3);
+DWIN_FONT(dwin_font_14x28, 4);
+DWIN_FONT(dwin_font_16x32, 5);
+DWIN_FONT(dwin_font_20x40, 6);
+DWIN_FONT(dwin_font_24x48, 7);
+DWIN_FONT(dwin_font_28x56, 8);
+DWIN_FONT(dwin_font_32x64, 9);
+
+//==============================================================================
+// NATIVE COMMAND QUEUES
+//==============================================================================
+// One queue per LVGL draw buffer. LVGL fills a queue while rendering into its
+// buffer and does not touch either again until the flush that empties the
+// queue has called lv_disp_flush_ready(), so the flush task needs no locking.
+//
+// Fills, frames and lines are still rasterized by LVGL as well: they are sent
+// before the buffer, which is then diffed against what they drew on the panel,
+// so anything LVGL painted over them afterwards is still sent as pixels.
+
+typedef enum {
+  DWIN_OP_FILL,
+  DWIN_OP_FRAME,
+  DWIN_OP_LINE,
+} dwin_native_op_type_t;
+
+typedef struct {
+  uint8_t type;
+  uint16_t color;
+  lv_area_t area;
+} dwin_native_op_t;
+
+// Drawn on top of the buffer's pixels: a string, or part of a sprite.
+typedef struct {
+  const dwin_font_dsc_t* font;      // NULL for a sprite
+  const dwin_sprite_t* sprite;
+  uint16_t color;
+  int16_t x;
+  int16_t y;
+  uint16_t start;   // First character in the queue's pool
+  uint16_t len;
+  lv_area_t part;   // Visible part of the sprite, in VRAM page coordinates
+} dwin_native_overlay_t;
+
+typedef struct {
+  const void* buf;
+  uint16_t ops;
+  uint16_t overlays;
+  uint16_t chars;
+  dwin_native_op_t op[DWIN_NATIVE_OPS_MAX];
+  dwin_native_overlay_t overlay[DWIN_NATIVE_TEXT_MAX];
+  char pool[DWIN_NATIVE_TEXT_CHARS];
+} dwin_native_queue_t;
+
+static dwin_native_queue_t native_queue[2];
+
+// Queue of the buffer being flushed, between dwin_draw_native_begin() and _end().
+static dwin_native_queue_t* flushing_queue = NULL;
+
+static dwin_native_queue_t* dwin_native_queue_for(const void* buf) {
+  for (uint8_t i = 0; i < 2; i++) {
+    if (buf && native_queue[i].buf == buf) return &native_queue[i];
+  }
+  return NULL;
+}
+
+/**
+ * @brief Queues a fill, frame or line clipped to the draw context's clip area.
+ * @note A full queue only costs bandwidth: the primitive is still in the pixels.
+ */
+static void dwin_native_queue_op(lv_draw_ctx_t* draw_ctx, uint8_t type, lv_color_t color, const lv_area_t* area) {
+  dwin_native_queue_t* q = dwin_native_queue_for(draw_ctx->buf);
+  lv_area_t clipped;
+  if (!q || q->ops >= DWIN_NATIVE_OPS_MAX || !_lv_area_intersect(&clipped, area, draw_ctx->clip_area)) return;
+
+  // A clipped frame is no longer a frame; send its visible sides as fills.
+  if (type == DWIN_OP_FRAME && !(clipped.x1 == area->x1 && clipped.y1 == area->y1 &&
+                                 clipped.x2 == area->x2 && clipped.y2 == area->y2)) {
+    lv_area_t sides[4] = {
+      {area->x1, area->y1, area->x2, area->y1},
+      {area->x1, area->y2, area->x2, area->y2},
+      {area->x1, area->y1, area->x1, area->y2},
+      {area->x2, area->y1, area->x2, area->y2},
+    };
+    for (uint8_t i = 0; i < 4; i++) dwin_native_queue_op(draw_ctx, DWIN_OP_FILL, color, &sides[i]);
+    return;
+  }
+
+  dwin_native_op_t* op = &q->op[q->ops++];
+  op->type = type;
+  op->color = lvgl_to_dwin_color(dwin_quantize_color(color));
+  op->area = clipped;
+}
+
+/**
+ * @brief Queues one glyph, extending the previous string when it continues it.
+ */
+static bool dwin_native_queue_glyph(dwin_native_queue_t* q, const dwin_font_dsc_t* f, uint16_t color,
+                                    int16_t x, int16_t y, char c) {
+  if (q->chars >= DWIN_NATIVE_TEXT_CHARS) return false;
+
+  dwin_native_overlay_t* last = q->overlays ? &q->overlay[q->overlays - 1] : NULL;
+  if (last && last->font == f && last->color == color && last->y == y &&
+      last->x + last->len * f->width == x) {
+    q->pool[q->chars++] = c;
+    last->len++;
+    return true;
+  }
+
+  if (q->overlays >= DWIN_NATIVE_TEXT_MAX) return false;
+  dwin_native_overlay_t* t = &q->overlay[q->overlays++];
+  t->font = f;
+  t->sprite = NULL;
+  t->color = color;
+  t->x = x;
+  t->y = y;
+  t->start = q->chars;
+  t->len = 1;
+  q->pool[q->chars++] = c;
+  return true;
+}
+
+/**
+ * @brief Queues the copy of a sprite's visible part.
+ */
+static bool dwin_native_queue_sprite(dwin_native_queue_t* q, const dwin_sprite_t* sprite,
+                                     const lv_area_t* part, int16_t x, int16_t y) {
+  if (q->overlays >= DWIN_NATIVE_TEXT_MAX) return false;
+  dwin_native_overlay_t* t = &q->overlay[q->overlays++];
+  t->font = NULL;
+  t->sprite = sprite;
+  t->x = x;
+  t->y = y;
+  t->part = *part;
+  return true;
+}
+
+//==============================================================================
+// DRAW CONTEXT
+//==============================================================================
+
+/**
+ * @brief Queues the parts of a rectangle the panel can draw: an opaque flat
+ * background and a full opaque border.
+ * @note Rounded corners are left to the pixels; the straight middle of a
+ * rounded background is still filled natively.
+ */
+static void dwin_native_queue_rect(lv_draw_ctx_t* draw_ctx, const lv_draw_rect_dsc_t* dsc, const lv_area_t* coords) {
+  if (dsc->blend_mode != LV_BLEND_MODE_NORMAL) return;
+  lv_coord_t w = lv_area_get_width(coords);
+  lv_coord_t h = lv_area_get_height(coords);
+  lv_coord_t r = LV_MIN(dsc->radius, LV_MIN(w, h) / 2);
+
+  if (dsc->bg_opa >= LV_OPA_MAX && dsc->bg_grad.dir == LV_GRAD_DIR_NONE) {
+    lv_area_t middle = {coords->x1, (lv_coord_t)(coords->y1 + r), coords->x2, (lv_coord_t)(coords->y2 - r)};
+    dwin_native_queue_op(draw_ctx, DWIN_OP_FILL, dsc->bg_color, &middle);
+    if (r > 0) {
+      lv_area_t top = {(lv_coord_t)(coords->x1 + r), coords->y1, (lv_coord_t)(coords->x2 - r), (lv_coord_t)(coords->y1 + r - 1)};
+      lv_area_t bottom = {(lv_coord_t)(coords->x1 + r), (lv_coord_t)(coords->y2 - r + 1), (lv_coord_t)(coords->x2 - r), coords->y2};
+      dwin_native_queue_op(draw_ctx, DWIN_OP_FILL, dsc->bg_color, &top);
+      dwin_native_queue_op(draw_ctx, DWIN_OP_FILL, dsc->bg_color, &bottom);
+    }
+  }
+
+  lv_coord_t bw = dsc->border_width;
+  if (bw > 0 && r == 0 && dsc->border_opa >= LV_OPA_MAX && dsc->border_side == LV_BORDER_SIDE_FULL) {
+    if (bw == 1) {
+      dwin_native_queue_op(draw_ctx, DWIN_OP_FRAME, dsc->border_color, coords);
+    } else {
+      lv_area_t sides[4] = {
+        {coords->x1, coords->y1, coords->x2, (lv_coord_t)(coords->y1 + bw - 1)},
+        {coords->x1, (lv_coord_t)(coords->y2 - bw + 1), coords->x2, coords->y2},
+        {coords->x1, coords->y1, (lv_coord_t)(coords->x1 + bw - 1), coords->y2},
+        {(lv_coord_t)(coords->x2 - bw + 1), coords->y1, coords->x2, coords->y2},
+      };
+      for (uint8_t i = 0; i < 4; i++) dwin_native_queue_op(draw_ctx, DWIN_OP_FILL, dsc->border_color, &sides[i]);
+    }
+  }
+}
+
+/**
+ * @brief draw_rect hook: queues the native parts, then rasterizes as usual.
+ */
+static void dwin_draw_rect_hook(lv_draw_ctx_t* draw_ctx, const lv_draw_rect_dsc_t* dsc, const lv_area_t* coords) {
+  dwin_native_queue_rect(draw_ctx, dsc, coords);
+  lv_draw_sw_rect(draw_ctx, dsc, coords);
+}
+
+/**
+ * @brief draw_bg hook (screen background): a plain fill when flat and opaque.
+ */
+static void dwin_draw_bg_hook(lv_draw_ctx_t* draw_ctx, const lv_draw_rect_dsc_t* dsc, const lv_area_t* coords) {
+  if (dsc->bg_opa >= LV_OPA_MAX && dsc->bg_grad.dir == LV_GRAD_DIR_NONE) {
+    dwin_native_queue_op(draw_ctx, DWIN_OP_FILL, dsc->bg_color, coords);
+  }
+  lv_draw_sw_bg(draw_ctx, dsc, coords);
+}
+
+/**
+ * @brief draw_line hook: 1 px solid horizontal and vertical lines become CMD_DRAW_LINE.
+ * @note Skewed lines are anti-aliased by LVGL, which the panel cannot reproduce.
+ */
+static void dwin_draw_line_hook(lv_draw_ctx_t* draw_ctx, const lv_draw_line_dsc_t* dsc,
+                                const lv_point_t* point1, const lv_point_t* point2) {
+  if (dsc->width == 1 && dsc->opa >= LV_OPA_MAX && dsc->dash_width == 0 &&
+      dsc->blend_mode == LV_BLEND_MODE_NORMAL &&
+      (point1->x == point2->x) != (point1->y == point2->y)) {
+    // Same extent as LVGL's software line: the end point is exclusive.
+    lv_area_t line;
+    line.x1 = LV_MIN(point1->x, point2->x);
+    line.y1 = LV_MIN(point1->y, point2->y);
+    line.x2 = point1->y == point2->y ? LV_MAX(point1->x, point2->x) - 1 : line.x1;
+    line.y2 = point1->x == point2->x ? LV_MAX(point1->y, point2->y) - 1 : line.y1;
+    dwin_native_queue_op(draw_ctx, DWIN_OP_LINE, dsc->color, &line);
+  }
+  lv_draw_sw_line(draw_ctx, dsc, point1, point2);
+}
+
+/**
+ * @brief draw_img hook: sprite sources are copied from VRAM instead of decoded.
+ * @return LV_RES_INV for any other source, so LVGL decodes it as usual.
+ * @note Only the part inside the clip area is copied. The panel copies the
+ * pixels as they are: a rotated, zoomed, faded (opa below LV_OPA_MAX),
+ * recolored or blended sprite has no pixels here to draw it from, so it is
+ * dropped.
+ */
+static lv_res_t dwin_draw_img_hook(lv_draw_ctx_t* draw_ctx, const lv_draw_img_dsc_t* dsc,
+                                   const lv_area_t* coords, const void* src) {
+  const dwin_sprite_t* sprite = dwin_atlas_from_src(src);
+  if (!sprite) return LV_RES_INV;
+
+  lv_area_t visible;
+  if (!_lv_area_intersect(&visible, coords, draw_ctx->clip_area)) return LV_RES_OK;
+
+  dwin_native_queue_t* q = dwin_native_queue_for(draw_ctx->buf);
+  lv_area_t part = {(lv_coord_t)(sprite->area.x1 + visible.x1 - coords->x1),
+                    (lv_coord_t)(sprite->area.y1 + visible.y1 - coords->y1),
+                    (lv_coord_t)(sprite->area.x1 + visible.x2 - coords->x1),
+                    (lv_coord_t)(sprite->area.y1 + visible.y2 - coords->y1)};
+  if (!q || dsc->angle != 0 || dsc->zoom != LV_IMG_ZOOM_NONE || dsc->opa < LV_OPA_MAX ||
+      dsc->recolor_opa > LV_OPA_MIN || dsc->blend_mode != LV_BLEND_MODE_NORMAL ||
+      !dwin_native_queue_sprite(q, sprite, &part, visible.x1, visible.y1)) {
+    draw_stats.dropped++;
+  }
+  return LV_RES_OK;
+}
+
+/**
+ * @brief Rasterizes a panel-font glyph the panel cannot draw in DWIN_FONT_FALLBACK.
+ */
+static void dwin_draw_fallback_letter(lv_draw_ctx_t* draw_ctx, const lv_draw_label_dsc_t* dsc,
+                                      const dwin_font_dsc_t* f, const lv_point_t* pos_p, uint32_t letter) {
+  const lv_font_t* font = DWIN_FONT_FALLBACK;
+  lv_font_glyph_dsc_t g;
+  lv_point_t pos = {pos_p->x, (lv_coord_t)(pos_p->y + (f->height - font->line_height) / 2)};
+  if (lv_font_get_glyph_dsc(font, &g, letter, 0)) pos.x += (f->width - g.adv_w) / 2;
+
+  lv_draw_label_dsc_t fallback = *dsc;
+  fallback.font = font;
+  lv_draw_sw_letter(draw_ctx, &fallback, &pos, letter);
+  draw_stats.fallback++;
+}
+
+/**
+ * @brief draw_letter hook: queues panel-font glyphs, rasterizes everything else.
+ * @note A glyph is queued every time it touches the clip area, because each
+ * flush of the rows under it paints the background over it again.
+ */
+static void dwin_draw_letter(lv_draw_ctx_t* draw_ctx, const lv_draw_label_dsc_t* dsc,
+                             const lv_point_t* pos_p, uint32_t letter) {
+  if (dsc->font->get_glyph_dsc != dwin_font_get_glyph_dsc) {
+    lv_draw_sw_letter(draw_ctx, dsc, pos_p, letter);
+    return;
+  }
+  if (dsc->opa <= LV_OPA_MIN || letter < 0x20 || letter > 0x7E) return;
+
+  const dwin_font_dsc_t* f = (const dwin_font_dsc_t*)dsc->font->dsc;
+  lv_area_t box = {pos_p->x, pos_p->y, (lv_coord_t)(pos_p->x + f->width - 1), (lv_coord_t)(pos_p->y + f->height - 1)};
+  lv_area_t visible;
+  if (!_lv_area_intersect(&visible, &box, draw_ctx->clip_area)) return;
+
+  // The panel cannot clip a glyph, nor draw into a layer LVGL blends later,
+  // so those glyphs are rasterized rather than drawn outside the clip area
+  // (a scrolled container) or off the panel.
+  dwin_native_queue_t* q = dwin_native_queue_for(draw_ctx->buf);
+  if (!q || box.x1 < draw_ctx->clip_area->x1 || box.x2 > draw_ctx->clip_area->x2 ||
+      box.y1 < 0 || box.y2 >= DWIN_HEIGHT ||
+      !dwin_native_queue_glyph(q, f, lvgl_to_dwin_color(dsc->color), box.x1, box.y1, (char)letter)) {
+    dwin_draw_fallback_letter(draw_ctx, dsc, f, pos_p, letter);
+  }
+}
+
+/**
+ * @brief Software draw context with the DWIN hooks installed (draw_ctx_init).
+ */
+void dwin_draw_ctx_init(lv_disp_drv_t* disp_drv, lv_draw_ctx_t* draw_ctx) {
+  lv_draw_sw_init_ctx(disp_drv, draw_ctx);
+  draw_ctx->draw_rect = dwin_draw_rect_hook;
+  draw_ctx->draw_bg = dwin_draw_bg_hook;
+  draw_ctx->draw_line = dwin_draw_line_hook;
+  draw_ctx->draw_img = dwin_draw_img_hook;
+  draw_ctx->draw_letter = dwin_draw_letter;
+
+  memset(native_queue, 0, sizeof(native_queue));
+  native_queue[0].buf = disp_drv->draw_buf->buf1;
+  native_queue[1].buf = disp_drv->draw_buf->buf2;
+}
+
+void dwin_draw_ctx_deinit(lv_disp_drv_t* disp_drv, lv_draw_ctx_t* draw_ctx) {
+  lv_draw_sw_deinit_ctx(disp_drv, draw_ctx);
+}
+
+/**
+ * @brief Sends the fills, frames and lines queued while rendering a draw buffer.
+ * @param buf The draw buffer about to be encoded.
+ * @return true if anything was sent; the buffer must then be encoded with
+ * dwin_draw_native_diff_row() so pixels the panel already shows are skipped.
+ */
+bool dwin_draw_native_begin(const lv_color_t* buf) {
+  flushing_queue = dwin_native_queue_for(buf);
+  if (!flushing_queue || !flushing_queue->ops) return false;
+
+  for (uint16_t i = 0; i < flushing_queue->ops; i++) {
+    const dwin_native_op_t* op = &flushing_queue->op[i];
+    const lv_area_t* a = &op->area;
+    if (op->type == DWIN_OP_LINE) {
+      dwin_draw_line(op->color, a->x1, a->y1, a->x2, a->y2);
+      draw_stats.lines++;
+    } else {
+      dwin_draw_rect(op->type == DWIN_OP_FRAME ? 0x00 : 0x01, op->color, a->x1, a->y1, a->x2, a->y2);
+      draw_stats.rects++;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Finds the columns of a row that differ from what the queued primitives drew.
+ * @param row Pixels of the row inside the flush area.
+ * @param x1 First column of the flush area.
+ * @param x2 Last column of the flush area.
+ * @param y Panel row.
+ * @param changed_x1 Set to the first column still to be sent.
+ * @param changed_x2 Set to the last column still to be sent.
+ * @return true if any pixel of the row has to be sent.
+ */
+bool dwin_draw_native_diff_row(const lv_color_t* row, int32_t x1, int32_t x2, int32_t y,
+                               int32_t* changed_x1, int32_t* changed_x2) {
+  static uint16_t drawn[DWIN_WIDTH];
+  static uint8_t known[DWIN_WIDTH];
+  memset(&known[x1], 0, x2 - x1 + 1);
+
+  // Replay the primitives on this row, in the order the panel drew them.
+  for (uint16_t i = 0; i < flushing_queue->ops; i++) {
+    const dwin_native_op_t* op = &flushing_queue->op[i];
+    const lv_area_t* a = &op->area;
+    if (y < a->y1 || y > a->y2) continue;
+    if (op->type == DWIN_OP_FRAME && y != a->y1 && y != a->y2) {
+      drawn[a->x1] = drawn[a->x2] = op->color;
+      known[a->x1] = known[a->x2] = 1;
+      continue;
+    }
+    for (int32_t x = max((int32_t)a->x1, x1); x <= min((int32_t)a->x2, x2); x++) {
+      drawn[x] = op->color;
+      known[x] = 1;
+    }
+  }
+
+  int32_t first = INT32_MAX;
+  int32_t last = -1;
+  for (int32_t x = x1; x <= x2; x++) {
+    if (known[x] && drawn[x] == lvgl_to_dwin_color(row[x - x1])) {
+      draw_stats.skipped_px++;
+    } else {
+      if (first == INT32_MAX) first = x;
+      last = x;
+    }
+  }
+
+  *changed_x1 = first;
+  *changed_x2 = last;
+  return last >= 0;
+}
+
+/**
+ * @brief Sends the strings and sprites queued while rendering a draw buffer and empties its queue.
+ * @param buf The draw buffer just encoded; call after its pixels, in the same batch.
+ * @note Primitives that were not sent with dwin_draw_native_begin() are dropped.
+ */
+void dwin_draw_native_end(const lv_color_t* buf) {
+  dwin_native_queue_t* q = dwin_native_queue_for(buf);
+  flushing_queue = NULL;
+  if (!q) return;
+
+  for (uint16_t i = 0; i < q->overlays; i++) {
+    const dwin_native_overlay_t* t = &q->overlay[i];
+    lv_area_t box;
+    if (t->sprite) {
+      if (dwin_atlas_blit(t->sprite, &t->part, t->x, t->y)) {
+        draw_stats.sprites++;
+      } else {
+        draw_stats.dropped++;
+      }
+      box.x1 = t->x;
+      box.y1 = t->y;
+      box.x2 = t->x + lv_area_get_width(&t->part) - 1;
+      box.y2 = t->y + lv_area_get_height(&t->part) - 1;
+    } else {
+      dwin_start_frame();
+      dwin_add_byte(CMD_DRAW_STRING);
+      dwin_add_byte(t->font->id);   // No background: only the glyph pixels are drawn
+      dwin_add_word(t->color);
+      dwin_add_word(COLOR_BLACK);
+      dwin_add_word(t->x);
+      dwin_add_word(t->y);
+      dwin_add_bytes((const uint8_t*)&q->pool[t->start], t->len);
+      dwin_send_frame();
+      draw_stats.strings++;
+      draw_stats.glyphs += t->len;
+      box.x1 = t->x;
+      box.y1 = t->y;
+      box.x2 = t->x + t->len * t->font->width - 1;
+      box.y2 = t->y + t->font->height - 1;
+    }
+
+    // The shadow only knows the background under the overlay.
+    dwin_shadow_invalidate_area(&box);
+  }
+  q->ops = 0;
+  q->overlays = 0;
+  q->chars = 0;
+}
+
+/**
+ * @brief Counters of primitives drawn natively by the panel.
+ */
+const dwin_draw_stats_t* dwin_draw_get_stats() {
+  return &draw_stats;
+}
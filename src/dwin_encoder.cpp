@@ -0,0 +1,851 @@
+#include <Arduino.h>
+#include <dwin.h>
+#include <dwin_encoder.h>
+
+// AA 02 [Color] [Nx] [Ny] followed by 4 bytes per point, then the tail.
+#define DWIN_POINTS_PER_FRAME ((DWIN_MAX_FRAME_SIZE - 6 - 4) / 4)
+
+// AA 08 [X] [Y] [Wide] [Color1] [Color0] and the tail leave this many bytes for bitmap rows.
+#define DWIN_BITMAP_BYTES_PER_FRAME (DWIN_MAX_FRAME_SIZE - 12 - 4)
+
+// Wire cost of the frames the encoders emit, header and tail included.
+#define DWIN_RECT_FRAME_BYTES 17
+#define DWIN_LINE_FRAME_BYTES 16
+#define DWIN_POINT_FRAME_BYTES 10     // AA 02 [Color] [Nx] [Ny] + tail
+#define DWIN_POINT_BYTES 4
+#define DWIN_BITMAP_FRAME_BYTES 16    // AA 08 [X] [Y] [Wide] [Color1] [Color0] + tail
+
+//==============================================================================
+// RUN SCANNING
+//==============================================================================
+
+#if DWIN_COLOR_NATIVE
+// Two native pixels read with one 32-bit load; may_alias keeps the compiler
+// from assuming lv_color_t and uint32_t never overlap.
+typedef uint32_t __attribute__((may_alias)) dwin_px_pair_t;
+#endif
+
+/**
+ * @brief Finds where the run of line[start]'s color ends.
+ * @return The first column after start with another color, or w.
+ * @details With native colors the row is compared a 32-bit word (two pixels)
+ * at a time once the pointer is word aligned, which halves the loads and
+ * branches spent on backgrounds and fills, the longest runs of a flush.
+ */
+static inline int32_t run_end(const lv_color_t* line, int32_t start, int32_t w) {
+  uint16_t color = line[start].full;
+  int32_t end = start + 1;
+#if DWIN_COLOR_NATIVE
+  // Most runs in text are a pixel or two long: check those one at a time,
+  // which also leaves end word aligned for the loop below.
+  while (end < w && ((uintptr_t)&line[end] & 2 || end - start < 2)) {
+    if (line[end].full != color) return end;
+    end++;
+  }
+  const uint32_t pair = color * 0x00010001u;
+  while (end + 1 < w) {
+    if (*(const dwin_px_pair_t*)&line[end] != pair) {
+      return line[end].full != color ? end : end + 1;
+    }
+    end += 2;
+  }
+#endif
+  while (end < w && line[end].full == color) {
+    end++;
+  }
+  return end;
+}
+
+//==============================================================================
+// ANALYSIS AND COST MODEL
+//==============================================================================
+
+typedef struct {
+  uint16_t color[DWIN_ANALYSIS_COLORS];
+  uint32_t count[DWIN_ANALYSIS_COLORS];   // Color histogram
+  uint8_t colors;                         // Distinct colors in the table
+  uint8_t last;                           // Table slot of the previous run's color
+  bool many_colors;                       // More colors than the table holds
+  uint32_t long_runs;                     // Runs of DWIN_SPAN_MIN_RUN pixels or more
+  uint32_t short_px;                      // Pixels in shorter runs
+  uint32_t rect_starts;                   // Long runs not continuing the same run of the row above
+  bool rows_uniform;                      // Every row is a single color
+  uint32_t row_bands;                     // Rows whose color differs from the row above
+  bool cols_uniform;                      // Every row repeats the first one
+  uint32_t col_bands;                     // Runs in the first row
+  const lv_color_t* first_line;
+  int32_t cols;
+  int32_t rows;
+} dwin_analysis_t;
+
+static dwin_encoder_stats_t encoder_stats;
+static dwin_encoding_t forced_encoding = DWIN_ENC_AUTO;
+
+static const char* const encoding_names[DWIN_ENC_COUNT] = {"solid", "bitmap", "spans", "rects", "points", "bands"};
+
+static void analysis_add_color(dwin_analysis_t* a, uint16_t color, uint32_t count) {
+  // Runs mostly alternate between a background and one or two foregrounds
+  if (a->colors > 0 && a->color[a->last] == color) {
+    a->count[a->last] += count;
+    return;
+  }
+  for (uint8_t i = 0; i < a->colors; i++) {
+    if (a->color[i] == color) {
+      a->count[i] += count;
+      a->last = i;
+      return;
+    }
+  }
+  if (a->colors < DWIN_ANALYSIS_COLORS) {
+    a->color[a->colors] = color;
+    a->count[a->colors] = count;
+    a->last = a->colors;
+    a->colors++;
+  } else {
+    a->many_colors = true;
+  }
+}
+
+/**
+ * @brief Cheap single pass over a block: histogram, run counts, vertical run
+ * continuity and gradient bands.
+ */
+static void analyse_block(const lv_color_t* px, int32_t stride, int32_t w, int32_t h, dwin_analysis_t* a) {
+  memset(a, 0, sizeof(*a));
+  a->rows = h;
+  a->cols = w;
+  a->first_line = px;
+  a->rows_uniform = true;
+  a->cols_uniform = true;
+  for (int32_t row = 0; row < h; row++) {
+    const lv_color_t* line = px + row * stride;
+    const lv_color_t* above = row > 0 ? line - stride : NULL;
+    if (above && a->cols_uniform) a->cols_uniform = memcmp(line, above, w * sizeof(lv_color_t)) == 0;
+    if (!above || above[0].full != line[0].full) a->row_bands++;
+    int32_t start = 0;
+    while (start < w) {
+      int32_t end = run_end(line, start, w);
+      int32_t len = end - start;
+      analysis_add_color(a, line[start].full, len);
+      if (len < DWIN_SPAN_MIN_RUN) {
+        a->short_px += len;
+      } else {
+        a->long_runs++;
+        bool continues = above &&
+                         above[start].full == line[start].full && above[end - 1].full == line[start].full &&
+                         (start == 0 || above[start - 1].full != line[start].full) &&
+                         (end == w || above[end].full != line[start].full);
+        if (!continues) a->rect_starts++;
+      }
+      if (row == 0) a->col_bands++;
+      if (len < w) a->rows_uniform = false;
+      start = end;
+    }
+  }
+}
+
+static void analysis_merge(dwin_analysis_t* into, const dwin_analysis_t* from) {
+  for (uint8_t i = 0; i < from->colors; i++) {
+    analysis_add_color(into, from->color[i], from->count[i]);
+  }
+  into->many_colors |= from->many_colors;
+  into->long_runs += from->long_runs;
+  into->short_px += from->short_px;
+  into->rect_starts += from->rect_starts;
+  into->rows_uniform &= from->rows_uniform;
+  into->row_bands += from->row_bands;
+  into->cols_uniform = into->cols_uniform && from->cols_uniform &&
+                       memcmp(into->first_line, from->first_line, into->cols * sizeof(lv_color_t)) == 0;
+  into->rows += from->rows;
+}
+
+/**
+ * @brief Bytes the point batch needs for a number of pixels spread over some colors.
+ */
+static uint32_t point_cost(uint32_t pixels, uint32_t colors) {
+  if (pixels == 0) return 0;
+  return pixels * DWIN_POINT_BYTES + (pixels / DWIN_POINTS_PER_FRAME + colors) * DWIN_POINT_FRAME_BYTES;
+}
+
+/**
+ * @brief Estimates the wire bytes of one encoding, or UINT32_MAX if it does not apply.
+ */
+static uint32_t estimate_cost(const dwin_analysis_t* a, int32_t w, dwin_encoding_t encoding) {
+  uint32_t colors = a->many_colors ? DWIN_ANALYSIS_COLORS * 2 : a->colors;
+  uint32_t pixels = (uint32_t)w * a->rows;
+
+  switch (encoding) {
+    case DWIN_ENC_SOLID:
+      return colors == 1 ? DWIN_RECT_FRAME_BYTES : UINT32_MAX;
+    case DWIN_ENC_BITMAP: {
+      if (colors != 2) return UINT32_MAX;
+      uint32_t row_bytes = (min(w, (int32_t)(DWIN_BITMAP_BYTES_PER_FRAME * 8)) + 7) / 8;
+      uint32_t strips = (w + DWIN_BITMAP_BYTES_PER_FRAME * 8 - 1) / (DWIN_BITMAP_BYTES_PER_FRAME * 8);
+      uint32_t rows_per_frame = DWIN_BITMAP_BYTES_PER_FRAME / row_bytes;
+      uint32_t frames = strips * ((a->rows + rows_per_frame - 1) / rows_per_frame);
+      return frames * DWIN_BITMAP_FRAME_BYTES + strips * row_bytes * a->rows;
+    }
+    case DWIN_ENC_SPANS:
+      return a->long_runs * DWIN_LINE_FRAME_BYTES + point_cost(a->short_px, colors);
+    case DWIN_ENC_RECTS:
+      return a->rect_starts * DWIN_RECT_FRAME_BYTES + point_cost(a->short_px, colors);
+    case DWIN_ENC_POINTS:
+      return point_cost(pixels, colors);
+    case DWIN_ENC_BANDS:
+      // Bands one pixel thick are lines, a byte cheaper than fills
+      if (a->rows_uniform) return a->row_bands * (a->row_bands == (uint32_t)a->rows ? DWIN_LINE_FRAME_BYTES : DWIN_RECT_FRAME_BYTES);
+      if (a->cols_uniform) return a->col_bands * (a->col_bands == (uint32_t)w ? DWIN_LINE_FRAME_BYTES : DWIN_RECT_FRAME_BYTES);
+      return UINT32_MAX;
+    default:
+      return UINT32_MAX;
+  }
+}
+
+static dwin_encoding_t choose_encoding(const dwin_analysis_t* a, int32_t w, uint32_t* cost) {
+  dwin_encoding_t best = DWIN_ENC_SPANS;
+  *cost = estimate_cost(a, w, DWIN_ENC_SPANS);
+  for (int e = 0; e < DWIN_ENC_COUNT; e++) {
+    uint32_t c = estimate_cost(a, w, (dwin_encoding_t)e);
+    if (c < *cost) {
+      best = (dwin_encoding_t)e;
+      *cost = c;
+    }
+  }
+  if (forced_encoding != DWIN_ENC_AUTO && best != DWIN_ENC_SOLID) {
+    uint32_t c = estimate_cost(a, w, forced_encoding);
+    if (c != UINT32_MAX) {
+      best = forced_encoding;
+      *cost = c;
+    }
+  }
+  return best;
+}
+
+static void encode_with(dwin_encoding_t encoding, const dwin_analysis_t* a, uint32_t cost,
+                        const lv_color_t* px, int32_t stride, int32_t x, int32_t y, int32_t w, int32_t h) {
+  encoder_stats.blocks[encoding]++;
+  encoder_stats.pixels[encoding] += w * h;
+  encoder_stats.est_bytes[encoding] += cost;
+
+  switch (encoding) {
+    case DWIN_ENC_SOLID:
+      dwin_draw_rect(0x01, lvgl_to_dwin_color(*px), x, y, x + w - 1, y + h - 1);
+      break;
+    case DWIN_ENC_BITMAP: {
+      // The less frequent color is the foreground (1 bits)
+      lv_color_t color1, color0;
+      bool first_is_bg = a->count[0] >= a->count[1];
+      color1.full = a->color[first_is_bg ? 1 : 0];
+      color0.full = a->color[first_is_bg ? 0 : 1];
+      dwin_encode_bitmap(px, stride, x, y, w, h, color1, color0);
+      break;
+    }
+    case DWIN_ENC_RECTS:
+      dwin_encode_rects(px, stride, x, y, w, h);
+      break;
+    case DWIN_ENC_POINTS:
+      dwin_encode_points(px, stride, x, y, w, h);
+      break;
+    case DWIN_ENC_BANDS:
+      dwin_encode_bands(px, stride, x, y, w, h);
+      break;
+    default:
+      dwin_encode_spans(px, stride, x, y, w, h);
+      break;
+  }
+}
+
+const dwin_encoder_stats_t* dwin_encoder_get_stats() {
+  return &encoder_stats;
+}
+
+void dwin_encoder_reset_stats() {
+  memset(&encoder_stats, 0, sizeof(encoder_stats));
+}
+
+const char* dwin_encoding_name(dwin_encoding_t encoding) {
+  return encoding >= 0 && encoding < DWIN_ENC_COUNT ? encoding_names[encoding] : "auto";
+}
+
+void dwin_encoder_force(dwin_encoding_t encoding) {
+  forced_encoding = encoding;
+}
+
+//==============================================================================
+// BLOCK ENCODER
+//==============================================================================
+
+/**
+ * @brief Encodes a block with the encoding the cost model expects to be cheapest.
+ * @details One analysis pass per tile of DWIN_SELECT_TILE_ROWS rows collects a
+ * color histogram, run counts and vertical run continuity. The wire bytes of
+ * every applicable encoding are estimated for the whole block and for each
+ * tile on its own; the block is split only if the per-tile choices add up to
+ * less. Decisions are counted in dwin_encoder_get_stats().
+ */
+void dwin_encode_block(const lv_color_t* px, int32_t stride, int32_t x, int32_t y, int32_t w, int32_t h) {
+  static dwin_analysis_t tiles[DWIN_SELECT_MAX_TILES];
+  static dwin_encoding_t tile_encoding[DWIN_SELECT_MAX_TILES];
+  static uint32_t tile_cost[DWIN_SELECT_MAX_TILES];
+  dwin_analysis_t whole;
+
+  int32_t tile_rows = max((int32_t)DWIN_SELECT_TILE_ROWS, (h + DWIN_SELECT_MAX_TILES - 1) / DWIN_SELECT_MAX_TILES);
+  int32_t tile_count = (h + tile_rows - 1) / tile_rows;
+  uint32_t tiled_cost = 0;
+
+  for (int32_t t = 0; t < tile_count; t++) {
+    int32_t rows = min(tile_rows, h - t * tile_rows);
+    analyse_block(px + t * tile_rows * stride, stride, w, rows, &tiles[t]);
+    tile_encoding[t] = choose_encoding(&tiles[t], w, &tile_cost[t]);
+    tiled_cost += tile_cost[t];
+    if (t == 0) {
+      whole = tiles[0];
+    } else {
+      analysis_merge(&whole, &tiles[t]);
+    }
+  }
+
+  uint32_t whole_cost;
+  dwin_encoding_t encoding = choose_encoding(&whole, w, &whole_cost);
+
+  encoder_stats.areas++;
+  if (tile_count == 1 || whole_cost <= tiled_cost) {
+    encode_with(encoding, &whole, whole_cost, px, stride, x, y, w, h);
+    return;
+  }
+
+  encoder_stats.tiled_areas++;
+  for (int32_t t = 0; t < tile_count; t++) {
+    int32_t rows = min(tile_rows, h - t * tile_rows);
+    encode_with(tile_encoding[t], &tiles[t], tile_cost[t], px + t * tile_rows * stride, stride,
+                x, y + t * tile_rows, w, rows);
+  }
+}
+
+/**
+ * @brief Runs the analysis pass and cost model on a block without sending
+ * anything or counting it in the stats (e.g. to time the analysis kernel).
+ * @param cost Set to the estimated wire bytes of the returned encoding.
+ * @return The encoding dwin_encode_block() would pick for the block as a whole.
+ */
+dwin_encoding_t dwin_encoder_choose(const lv_color_t* px, int32_t stride, int32_t w, int32_t h, uint32_t* cost) {
+  dwin_analysis_t a;
+  analyse_block(px, stride, w, h, &a);
+  return choose_encoding(&a, w, cost);
+}
+
+//==============================================================================
+// COLOR QUANTIZATION
+//==============================================================================
+
+static dwin_quant_mode_t quant_mode = DWIN_QUANTIZE;
+static uint8_t quant_level = DWIN_QUANTIZE == DWIN_QUANT_PALETTE ? DWIN_QUANT_PALETTE_BITS : DWIN_QUANT_TOLERANCE_BUDGET;
+
+// Palette mode: every RGB565 channel value mapped to its palette level.
+static uint8_t quant_lut_r[32];
+static uint8_t quant_lut_g[64];
+static uint8_t quant_lut_b[32];
+static bool quant_lut_ready = false;
+static uint8_t quant_max_error = 0;
+
+/**
+ * @brief Maps each value of a channel with 2^bits values to the nearest of
+ * `levels` evenly spaced values.
+ */
+static void quant_build_lut(uint8_t* lut, uint8_t bits, uint32_t levels) {
+  uint32_t top = (1u << bits) - 1;
+  for (uint32_t v = 0; v <= top; v++) {
+    uint32_t level = (v * (levels - 1) + top / 2) / top;
+    lut[v] = (level * top + (levels - 1) / 2) / (levels - 1);
+  }
+}
+
+static void quant_prepare() {
+  if (quant_lut_ready) return;
+  uint8_t bits = quant_level < 1 ? 1 : quant_level > 5 ? 5 : quant_level;
+  quant_build_lut(quant_lut_r, 5, 1u << bits);
+  quant_build_lut(quant_lut_g, 6, 2u << bits);
+  quant_build_lut(quant_lut_b, 5, 1u << bits);
+
+  // Worst case over the palette, for dwin_quantize_max_error()
+  uint8_t er = 0, eg = 0, eb = 0;
+  for (uint8_t v = 0; v < 32; v++) {
+    er = max(er, (uint8_t)(abs(quant_lut_r[v] - v) << 3));
+    eb = max(eb, (uint8_t)(abs(quant_lut_b[v] - v) << 3));
+  }
+  for (uint8_t v = 0; v < 64; v++) eg = max(eg, (uint8_t)(abs(quant_lut_g[v] - v) << 2));
+  quant_max_error = (3 * er + 6 * eg + eb + 9) / 10;
+  quant_lut_ready = true;
+}
+
+/**
+ * @brief Selects the quantization stage.
+ * @param mode DWIN_QUANT_LOSSLESS turns it off.
+ * @param level Palette bits (1-5) or error budget, depending on the mode.
+ */
+void dwin_quantize_set(dwin_quant_mode_t mode, uint8_t level) {
+  quant_mode = mode;
+  quant_level = level;
+  quant_lut_ready = false;
+}
+
+dwin_quant_mode_t dwin_quantize_mode() {
+  return quant_mode;
+}
+
+/**
+ * @brief Largest error a pixel can get from the current mode (0 when lossless).
+ */
+uint8_t dwin_quantize_max_error() {
+  switch (quant_mode) {
+    case DWIN_QUANT_PALETTE:
+      quant_prepare();
+      return quant_max_error;
+    case DWIN_QUANT_TOLERANCE:
+      return quant_level;
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief Perceptual distance between two RGB565 colors, in 8-bit units.
+ */
+uint8_t dwin_quantize_error(uint16_t a, uint16_t b) {
+  uint32_t dr = abs((int)(a >> 11) - (int)(b >> 11)) << 3;
+  uint32_t dg = abs((int)((a >> 5) & 0x3F) - (int)((b >> 5) & 0x3F)) << 2;
+  uint32_t db = abs((int)(a & 0x1F) - (int)(b & 0x1F)) << 3;
+  return (3 * dr + 6 * dg + db + 9) / 10;
+}
+
+/**
+ * @brief Color a flat fill of this color gets from the quantization stage.
+ * @note Native fills are sent in this color so the pixels around them still
+ * match. Only the palette mode changes single colors.
+ */
+lv_color_t dwin_quantize_color(lv_color_t color) {
+  if (quant_mode != DWIN_QUANT_PALETTE) return color;
+  quant_prepare();
+  uint16_t c = lvgl_to_dwin_color(color);
+  uint8_t r = quant_lut_r[c >> 11];
+  uint8_t g = quant_lut_g[(c >> 5) & 0x3F];
+  uint8_t b = quant_lut_b[c & 0x1F];
+#if DWIN_COLOR_NATIVE
+  color.full = (r << 11) | (g << 5) | b;
+#else
+  // Back to LVGL's format; expanding 5/6 bits to 8 keeps the RGB565 value exact.
+  color = lv_color_make((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+#endif
+  return color;
+}
+
+/**
+ * @brief Quantizes a block of pixels in place, before it is diffed and encoded.
+ * @note The tolerance mode lengthens horizontal runs first (the color on the
+ * left is kept while within the budget of each pixel), then vertical ones
+ * (the pixel above). Colors never drift: each pixel stays within the budget
+ * of its own color.
+ */
+void dwin_quantize_area(lv_color_t* px, int32_t stride, int32_t w, int32_t h) {
+  if (quant_mode == DWIN_QUANT_PALETTE) {
+    for (int32_t row = 0; row < h; row++) {
+      lv_color_t* line = px + row * stride;
+      for (int32_t col = 0; col < w; col++) {
+        lv_color_t q = dwin_quantize_color(line[col]);
+        if (q.full != line[col].full) {
+          line[col] = q;
+          encoder_stats.quantized_px++;
+        }
+      }
+    }
+  } else if (quant_mode == DWIN_QUANT_TOLERANCE && quant_level > 0) {
+    for (int32_t row = 0; row < h; row++) {
+      lv_color_t* line = px + row * stride;
+      const lv_color_t* above = row > 0 ? line - stride : NULL;
+      for (int32_t col = 0; col < w; col++) {
+        uint16_t c = lv_color_to16(line[col]);
+        lv_color_t q = line[col];
+        if (col > 0 && dwin_quantize_error(c, lv_color_to16(line[col - 1])) <= quant_level) {
+          q = line[col - 1];
+        } else if (above && dwin_quantize_error(c, lv_color_to16(above[col])) <= quant_level) {
+          q = above[col];
+        }
+        if (q.full != line[col].full) {
+          line[col] = q;
+          encoder_stats.quantized_px++;
+        }
+      }
+    }
+  }
+}
+
+//==============================================================================
+// COLOR-BUCKETED POINT BATCH
+//==============================================================================
+
+static uint16_t batch_color[DWIN_POINT_BATCH_COLORS];
+static int16_t batch_head[DWIN_POINT_BATCH_COLORS];
+static uint8_t batch_colors = 0;
+
+static uint16_t point_x[DWIN_POINT_BATCH_MAX];
+static uint16_t point_y[DWIN_POINT_BATCH_MAX];
+static int16_t point_next[DWIN_POINT_BATCH_MAX];
+static uint16_t batch_points = 0;
+
+/**
+ * @brief Queues one pixel in the bucket of its color.
+ * @param dwin_color The RGB565 color.
+ * @param x The x-coordinate.
+ * @param y The y-coordinate.
+ * @note The batch is sent automatically when it runs out of points or colors.
+ */
+void dwin_point_batch_add(uint16_t dwin_color, uint16_t x, uint16_t y) {
+  uint8_t bucket = 0;
+  while (bucket < batch_colors && batch_color[bucket] != dwin_color) {
+    bucket++;
+  }
+
+  if (batch_points >= DWIN_POINT_BATCH_MAX || bucket >= DWIN_POINT_BATCH_COLORS) {
+    dwin_point_batch_flush();
+    bucket = 0;
+  }
+  if (bucket == batch_colors) {
+    batch_color[bucket] = dwin_color;
+    batch_head[bucket] = -1;
+    batch_colors++;
+  }
+
+  point_x[batch_points] = x;
+  point_y[batch_points] = y;
+  point_next[batch_points] = batch_head[bucket];
+  batch_head[bucket] = batch_points;
+  batch_points++;
+}
+
+/**
+ * @brief Sends every queued pixel, one or more CMD_SET_POINT frames per color.
+ */
+void dwin_point_batch_flush() {
+  for (uint8_t bucket = 0; bucket < batch_colors; bucket++) {
+    int16_t i = batch_head[bucket];
+    while (i >= 0) {
+      // DWIN Frame: AA 02 [Color] [Nx] [Ny] (X0 Y0)...(Xn Yn) CC 33 C3 3C
+      dwin_start_frame();
+      dwin_add_byte(CMD_SET_POINT);
+      dwin_add_word(batch_color[bucket]);
+      dwin_add_byte(0x01); // Nx: 1 pixel width
+      dwin_add_byte(0x01); // Ny: 1 pixel height
+      for (uint16_t n = 0; n < DWIN_POINTS_PER_FRAME && i >= 0; n++) {
+        dwin_add_word(point_x[i]);
+        dwin_add_word(point_y[i]);
+        i = point_next[i];
+      }
+      dwin_send_frame();
+    }
+  }
+  batch_colors = 0;
+  batch_points = 0;
+}
+
+//==============================================================================
+// SPAN ENCODER
+//==============================================================================
+
+/**
+ * @brief Encodes a block as horizontal runs of the same color.
+ * @details Each run of DWIN_SPAN_MIN_RUN pixels or more becomes one
+ * CMD_DRAW_LINE segment (16 bytes on the wire, one byte less than a one-row
+ * CMD_DRAW_RECT fill). Shorter runs cost 4 bytes per pixel in the point batch,
+ * which is sent before returning.
+ */
+void dwin_encode_spans(const lv_color_t* px, int32_t stride, int32_t x, int32_t y, int32_t w, int32_t h) {
+  for (int32_t row = 0; row < h; row++) {
+    const lv_color_t* line = px + row * stride;
+    int32_t start = 0;
+    while (start < w) {
+      int32_t end = run_end(line, start, w);
+      uint16_t dwin_color = lvgl_to_dwin_color(line[start]);
+      if (end - start < DWIN_SPAN_MIN_RUN) {
+        for (int32_t i = start; i < end; i++) {
+          dwin_point_batch_add(dwin_color, x + i, y + row);
+        }
+      } else {
+        dwin_draw_line(dwin_color, x + start, y + row, x + end - 1, y + row);
+      }
+      start = end;
+    }
+  }
+  dwin_point_batch_flush();
+}
+
+//==============================================================================
+// RECTANGLE ENCODER
+//==============================================================================
+
+static uint8_t rect_covered[(DWIN_RECT_MAX_AREA + 7) / 8];
+
+static inline bool rect_is_covered(int32_t i) {
+  return rect_covered[i >> 3] & (1 << (i & 7));
+}
+
+static inline void rect_cover(int32_t i) {
+  rect_covered[i >> 3] |= 1 << (i & 7);
+}
+
+/**
+ * @brief Sends one same-color rectangle with the cheapest command for its shape.
+ */
+static void rect_emit(uint16_t dwin_color, int32_t x, int32_t y, int32_t w, int32_t h) {
+  if (w * h < DWIN_SPAN_MIN_RUN) {
+    for (int32_t r = 0; r < h; r++) {
+      for (int32_t c = 0; c < w; c++) {
+        dwin_point_batch_add(dwin_color, x + c, y + r);
+      }
+    }
+  } else if (h == 1 || w == 1) {
+    dwin_draw_line(dwin_color, x, y, x + w - 1, y + h - 1);
+  } else {
+    dwin_draw_rect(0x01, dwin_color, x, y, x + w - 1, y + h - 1);
+  }
+}
+
+/**
+ * @brief Encodes a block as greedy maximal same-color rectangles.
+ * @details Pixels are visited in raster order; each uncovered pixel starts a
+ * rectangle that grows right along its run, then down while the whole row
+ * segment keeps the same color. Each rectangle costs one 17-byte
+ * CMD_DRAW_RECT fill, so tall uniform regions (button bodies, slider tracks,
+ * panel borders) cost one frame instead of one per row.
+ * The analysis stops after DWIN_RECT_WORK_PER_PX comparisons per pixel and
+ * the uncovered remainder is sent as runs, so a noisy block never costs much
+ * more CPU than the plain span encoder.
+ */
+void dwin_encode_rects(const lv_color_t* px, int32_t stride, int32_t x, int32_t y, int32_t w, int32_t h) {
+  int32_t band_rows = max((int32_t)1, (int32_t)(DWIN_RECT_MAX_AREA / w));
+  if (w > DWIN_RECT_MAX_AREA) {
+    dwin_encode_spans(px, stride, x, y, w, h);
+    return;
+  }
+
+  for (int32_t band = 0; band < h; band += band_rows) {
+    const lv_color_t* bpx = px + band * stride;
+    int32_t bh = min(band_rows, h - band);
+    int32_t work_left = DWIN_RECT_WORK_PER_PX * w * bh;
+    memset(rect_covered, 0, (w * bh + 7) / 8);
+
+    for (int32_t r = 0; r < bh; r++) {
+      const lv_color_t* line = bpx + r * stride;
+      for (int32_t c = 0; c < w; c++) {
+        if (rect_is_covered(r * w + c)) continue;
+        lv_color_t color = line[c];
+        uint16_t dwin_color = lvgl_to_dwin_color(color);
+
+        if (work_left <= 0) {
+          // Out of budget: plain runs over what is still uncovered.
+          int32_t end = c + 1;
+          while (end < w && !rect_is_covered(r * w + end) && line[end].full == color.full) {
+            end++;
+          }
+          rect_emit(dwin_color, x + c, y + band + r, end - c, 1);
+          c = end - 1;
+          continue;
+        }
+
+        int32_t rw = 1;
+        while (c + rw < w && !rect_is_covered(r * w + c + rw) && line[c + rw].full == color.full) {
+          rw++;
+        }
+        work_left -= rw;
+
+        int32_t rh = 1;
+        while (r + rh < bh) {
+          const lv_color_t* next = bpx + (r + rh) * stride + c;
+          int32_t i = 0;
+          while (i < rw && !rect_is_covered((r + rh) * w + c + i) && next[i].full == color.full) {
+            i++;
+          }
+          work_left -= i + 1;
+          if (i < rw) break;
+          rh++;
+        }
+
+        for (int32_t rr = 0; rr < rh; rr++) {
+          for (int32_t i = 0; i < rw; i++) {
+            rect_cover((r + rr) * w + c + i);
+          }
+        }
+        rect_emit(dwin_color, x + c, y + band + r, rw, rh);
+        c += rw - 1;
+      }
+    }
+  }
+  dwin_point_batch_flush();
+}
+
+//==============================================================================
+// GRADIENT BAND ENCODER
+//==============================================================================
+
+static void dwin_encode_band(lv_color_t color, int32_t xs, int32_t ys, int32_t xe, int32_t ye) {
+  if (xs == xe || ys == ye) {
+    dwin_draw_line(lvgl_to_dwin_color(color), xs, ys, xe, ye);
+  } else {
+    dwin_draw_rect(0x01, lvgl_to_dwin_color(color), xs, ys, xe, ye);
+  }
+}
+
+/**
+ * @brief Encodes a block whose rows (vertical gradient) or columns
+ * (horizontal gradient) are each a single color as one CMD_DRAW_RECT fill per
+ * band of equal rows or columns (CMD_DRAW_LINE for bands one pixel thick).
+ * @note Falls back to spans for any other block.
+ */
+void dwin_encode_bands(const lv_color_t* px, int32_t stride, int32_t x, int32_t y, int32_t w, int32_t h) {
+  bool rows_uniform = true;
+  for (int32_t row = 0; row < h && rows_uniform; row++) {
+    rows_uniform = run_end(px + row * stride, 0, w) == w;
+  }
+
+  if (rows_uniform) {
+    int32_t band = 0;
+    for (int32_t row = 1; row <= h; row++) {
+      if (row < h && px[row * stride].full == px[band * stride].full) continue;
+      dwin_encode_band(px[band * stride], x, y + band, x + w - 1, y + row - 1);
+      band = row;
+    }
+    return;
+  }
+
+  for (int32_t row = 1; row < h; row++) {
+    if (memcmp(px + row * stride, px, w * sizeof(lv_color_t)) != 0) {
+      dwin_encode_spans(px, stride, x, y, w, h);
+      return;
+    }
+  }
+  int32_t band = 0;
+  for (int32_t col = 1; col <= w; col++) {
+    if (col < w && px[col].full == px[band].full) continue;
+    dwin_encode_band(px[band], x + band, y, x + col - 1, y + h - 1);
+    band = col;
+  }
+}
+
+//==============================================================================
+// POINT ENCODER
+//==============================================================================
+
+/**
+ * @brief Encodes every pixel of a block through the color-bucketed point batch.
+ * @details Best for anti-aliased text: few distinct colors, many short runs.
+ */
+void dwin_encode_points(const lv_color_t* px, int32_t stride, int32_t x, int32_t y, int32_t w, int32_t h) {
+  for (int32_t row = 0; row < h; row++) {
+    const lv_color_t* line = px + row * stride;
+    for (int32_t col = 0; col < w; col++) {
+      dwin_point_batch_add(lvgl_to_dwin_color(line[col]), x + col, y + row);
+    }
+  }
+  dwin_point_batch_flush();
+}
+
+//==============================================================================
+// TWO-COLOR BITMAP ENCODER
+//==============================================================================
+
+/**
+ * @brief Tells whether data, following the 3 bytes in before, contains FRAME_TAIL.
+ * @details The panel ends a frame at the first tail it sees, so packed bitmap
+ * bytes must never form one, not even across a row or header boundary.
+ */
+static bool bitmap_forms_tail(const uint8_t* before, const uint8_t* data, int32_t n) {
+  for (int32_t p = -3; p + 4 <= n; p++) {
+    int32_t i = 0;
+    while (i < 4 && (p + i < 0 ? before[3 + p + i] : data[p + i]) == FRAME_TAIL[i]) i++;
+    if (i == 4) return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Shifts n data bytes into the 3 byte window that precedes the next ones.
+ */
+static void bitmap_slide(uint8_t* before, const uint8_t* data, int32_t n) {
+  for (int32_t i = 0; i < n; i++) {
+    before[0] = before[1];
+    before[1] = before[2];
+    before[2] = data[i];
+  }
+}
+
+/**
+ * @brief Encodes a block that holds only two colors as 1 bpp CMD_DRAW_BITMAP frames.
+ * @details Every row is packed into ceil(width / 8) bytes, leftmost pixel in the
+ * most significant bit, and each frame carries as many whole rows as fit.
+ * Blocks wider than one frame can hold are split into vertical strips.
+ * A row that would complete FRAME_TAIL starts a new frame instead, and a row
+ * that forms it even right after the header is sent as spans.
+ * @param color1 Pixels of this color are sent as 1 bits.
+ * @param color0 Color drawn for 0 bits; every other pixel must have this color.
+ */
+void dwin_encode_bitmap(const lv_color_t* px, int32_t stride, int32_t x, int32_t y, int32_t w, int32_t h,
+                        lv_color_t color1, lv_color_t color0) {
+  const int32_t max_strip = DWIN_BITMAP_BYTES_PER_FRAME * 8;
+  uint16_t dwin_color1 = lvgl_to_dwin_color(color1);
+  uint16_t dwin_color0 = lvgl_to_dwin_color(color0);
+  uint8_t bits[DWIN_BITMAP_BYTES_PER_FRAME];
+
+  for (int32_t strip = 0; strip < w; strip += max_strip) {
+    int32_t wide = min(w - strip, max_strip);
+    int32_t row_bytes = (wide + 7) / 8;
+    int32_t rows_per_frame = DWIN_BITMAP_BYTES_PER_FRAME / row_bytes;
+    int32_t frame_rows = 0;   // Rows in the open frame, 0 when none is open
+    uint8_t before[3];        // Last bytes of the open frame
+
+    for (int32_t row = 0; row < h; row++) {
+      const lv_color_t* line = px + row * stride + strip;
+      for (int32_t b = 0; b < row_bytes; b++) {
+        bits[b] = 0;
+        int32_t count = min(wide - b * 8, (int32_t)8);
+        for (int32_t i = 0; i < count; i++) {
+          if (line[b * 8 + i].full == color1.full) {
+            bits[b] |= 0x80 >> i;
+          }
+        }
+      }
+
+      if (frame_rows == rows_per_frame || (frame_rows > 0 && bitmap_forms_tail(before, bits, row_bytes))) {
+        dwin_send_frame();
+        frame_rows = 0;
+      }
+
+      if (frame_rows == 0) {
+        // DWIN Frame: AA 08 [X] [Y] [Wide] [Color1] [Color0] [data] CC 33 C3 3C
+        const uint8_t header[] = {
+          CMD_DRAW_BITMAP,
+          (uint8_t)((x + strip) >> 8), (uint8_t)(x + strip),
+          (uint8_t)((y + row) >> 8), (uint8_t)(y + row),
+          (uint8_t)(wide >> 8), (uint8_t)wide,
+          (uint8_t)(dwin_color1 >> 8), (uint8_t)dwin_color1,
+          (uint8_t)(dwin_color0 >> 8), (uint8_t)dwin_color0,
+        };
+        before[0] = 0; before[1] = 0; before[2] = FRAME_HEADER;
+        if (bitmap_forms_tail(before, header, sizeof(header))) {
+          dwin_encode_spans(px + row * stride + strip, stride, x + strip, y + row, wide, h - row);
+          break;
+        }
+        bitmap_slide(before, header, sizeof(header));
+        if (bitmap_forms_tail(before, bits, row_bytes)) {
+          dwin_encode_spans(line, stride, x + strip, y + row, wide, 1);
+          continue;
+        }
+        dwin_start_frame();
+        for (size_t i = 0; i < sizeof(header); i++) dwin_add_byte(header[i]);
+      }
+
+      for (int32_t b = 0; b < row_bytes; b++) dwin_add_byte(bits[b]);
+      bitmap_slide(before, bits, row_bytes);
+      frame_rows++;
+    }
+    if (frame_rows > 0) dwin_send_frame();
+  }
+}
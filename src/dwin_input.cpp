@@ -0,0 +1,250 @@
+/**
+ * @file dwin_input.cpp
+ * @brief Interrupt-driven rotary knob decoder and LVGL encoder input device.
+ */
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <dwin_input.h>
+
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+#if (DWIN_KNOB_QUEUE & (DWIN_KNOB_QUEUE - 1)) != 0
+#error "DWIN_KNOB_QUEUE must be a power of two"
+#endif
+
+typedef enum {
+  DWIN_INPUT_LEFT,
+  DWIN_INPUT_RIGHT,
+  DWIN_INPUT_PRESS,
+  DWIN_INPUT_RELEASE
+} dwin_input_kind_t;
+
+typedef struct {
+  uint8_t kind;         // dwin_input_kind_t
+  uint32_t edge_us;     // micros() at the edge that completed the event
+} dwin_input_event_t;
+
+// Single producer (the pin interrupts, which run one at a time) and single
+// consumer (the LVGL read callback). Head and tail are free-running.
+static dwin_input_event_t queue[DWIN_KNOB_QUEUE];
+static volatile uint8_t queue_head = 0;
+static volatile uint8_t queue_tail = 0;
+
+// Quadrature state: previous AB levels and steps since the last detent.
+static volatile uint8_t knob_ab = 0;
+static volatile int8_t knob_steps = 0;
+
+// Button state as last queued, and when that edge was accepted.
+static volatile bool button_down = false;
+static volatile uint32_t button_edge_us = 0;
+static bool button_reported = false;
+
+// Latency: edge of the oldest input LVGL has read and no flush has started
+// for yet, then of the input the running flush shows.
+static volatile uint32_t read_edge_us = 0;
+static volatile bool read_pending = false;
+static volatile uint32_t flush_edge_us = 0;
+static volatile bool flush_pending = false;
+
+static dwin_input_stats_t input_stats;
+static lv_indev_drv_t indev_drv;
+static lv_indev_t* indev = NULL;
+
+#if defined(ESP32)
+static TaskHandle_t wake_task = NULL;
+static portMUX_TYPE input_mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+// Step for each (previous AB << 2 | current AB); invalid double transitions count 0.
+static const int8_t QUADRATURE_STEP[16] = {0, -1, 1, 0, 1, 0, 0, -1, -1, 0, 0, 1, 0, 1, -1, 0};
+
+static void IRAM_ATTR dwin_input_push(uint8_t kind) {
+  uint8_t head = queue_head;
+  if ((uint8_t)(head - queue_tail) >= DWIN_KNOB_QUEUE) {
+    input_stats.dropped++;
+    return;
+  }
+  queue[head & (DWIN_KNOB_QUEUE - 1)].kind = kind;
+  queue[head & (DWIN_KNOB_QUEUE - 1)].edge_us = micros();
+  queue_head = head + 1;
+
+#if defined(ESP32)
+  if (wake_task) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(wake_task, &woken);
+    if (woken) portYIELD_FROM_ISR();
+  }
+#endif
+}
+
+/**
+ * @brief Decodes a change of the knob's A/B levels; called by the pin interrupts.
+ * @note A detent is queued once DWIN_KNOB_STEPS_PER_DETENT valid steps in the
+ * same direction have accumulated, so contact chatter cancels itself out.
+ */
+void IRAM_ATTR dwin_input_quadrature(bool a, bool b) {
+  uint8_t ab = (a ? 2 : 0) | (b ? 1 : 0);
+  int8_t step = QUADRATURE_STEP[(knob_ab << 2) | ab];
+  knob_ab = ab;
+  if (step == 0) return;
+
+  int8_t steps = knob_steps + (DWIN_KNOB_REVERSE ? -step : step);
+  if (steps >= DWIN_KNOB_STEPS_PER_DETENT || steps <= -DWIN_KNOB_STEPS_PER_DETENT) {
+    dwin_input_push(steps > 0 ? DWIN_INPUT_RIGHT : DWIN_INPUT_LEFT);
+    input_stats.steps++;
+    steps = 0;
+  }
+  knob_steps = steps;
+}
+
+/**
+ * @brief Debounces a change of the push button; called by the pin interrupt.
+ * @note The first edge is taken at once; edges in the next
+ * DWIN_KNOB_DEBOUNCE_MS are bounce. The read callback catches up with the
+ * level if the button settled otherwise.
+ */
+void IRAM_ATTR dwin_input_button(bool pressed) {
+  uint32_t now = micros();
+  if (now - button_edge_us < DWIN_KNOB_DEBOUNCE_MS * 1000UL) {
+    input_stats.bounces++;
+    return;
+  }
+  if (pressed == button_down) return;
+  button_down = pressed;
+  button_edge_us = now;
+  if (pressed) input_stats.presses++;
+  dwin_input_push(pressed ? DWIN_INPUT_PRESS : DWIN_INPUT_RELEASE);
+}
+
+#if defined(ESP32)
+static void IRAM_ATTR dwin_input_knob_isr() {
+  dwin_input_quadrature(digitalRead(DWIN_KNOB_PIN_A) == LOW, digitalRead(DWIN_KNOB_PIN_B) == LOW);
+}
+
+static void IRAM_ATTR dwin_input_button_isr() {
+  dwin_input_button(digitalRead(DWIN_KNOB_PIN_BTN) == LOW);
+}
+#endif
+
+/**
+ * @brief LVGL read callback: hands the queued events to LVGL.
+ * @details Turns are summed into enc_diff; each button change is reported on
+ * its own read (continue_reading asks LVGL to read again at once), so a quick
+ * click is never lost between two reads.
+ */
+static void dwin_input_read(lv_indev_drv_t* drv, lv_indev_data_t* data) {
+#if defined(ESP32)
+  // A release (or press) that came in as bounce is recovered once the
+  // debounce time is over.
+  portENTER_CRITICAL(&input_mux);
+  if (micros() - button_edge_us >= DWIN_KNOB_DEBOUNCE_MS * 1000UL) {
+    dwin_input_button(digitalRead(DWIN_KNOB_PIN_BTN) == LOW);
+  }
+  portEXIT_CRITICAL(&input_mux);
+#endif
+
+  data->enc_diff = 0;
+  while (queue_tail != queue_head) {
+    const dwin_input_event_t* ev = &queue[queue_tail & (DWIN_KNOB_QUEUE - 1)];
+    bool turn = ev->kind == DWIN_INPUT_LEFT || ev->kind == DWIN_INPUT_RIGHT;
+    if (!turn && data->enc_diff != 0) {
+      data->continue_reading = true;
+      break;
+    }
+    if (turn) {
+      data->enc_diff += ev->kind == DWIN_INPUT_RIGHT ? 1 : -1;
+    } else {
+      button_reported = ev->kind == DWIN_INPUT_PRESS;
+    }
+    if (!read_pending) {
+      read_edge_us = ev->edge_us;
+      read_pending = true;
+    }
+    queue_tail = queue_tail + 1;
+    if (!turn) {
+      data->continue_reading = queue_tail != queue_head;
+      break;
+    }
+  }
+  data->state = button_reported ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+}
+
+/**
+ * @brief Registers the knob as an LVGL encoder and enables its interrupts.
+ * @return The input device. Widgets created afterwards join the default
+ * group it navigates.
+ * @note Call after lvgl_driver_init(), from the task that runs lv_timer_handler().
+ */
+lv_indev_t* dwin_input_init() {
+  lv_indev_drv_init(&indev_drv);
+  indev_drv.type = LV_INDEV_TYPE_ENCODER;
+  indev_drv.read_cb = dwin_input_read;
+  indev = lv_indev_drv_register(&indev_drv);
+
+  lv_group_t* group = lv_group_create();
+  lv_group_set_default(group);
+  lv_indev_set_group(indev, group);
+
+#if defined(ESP32)
+  wake_task = xTaskGetCurrentTaskHandle();
+  pinMode(DWIN_KNOB_PIN_A, INPUT_PULLUP);
+  pinMode(DWIN_KNOB_PIN_B, INPUT_PULLUP);
+  pinMode(DWIN_KNOB_PIN_BTN, INPUT_PULLUP);
+  knob_ab = (digitalRead(DWIN_KNOB_PIN_A) == LOW ? 2 : 0) | (digitalRead(DWIN_KNOB_PIN_B) == LOW ? 1 : 0);
+  attachInterrupt(digitalPinToInterrupt(DWIN_KNOB_PIN_A), dwin_input_knob_isr, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(DWIN_KNOB_PIN_B), dwin_input_knob_isr, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(DWIN_KNOB_PIN_BTN), dwin_input_button_isr, CHANGE);
+#endif
+  return indev;
+}
+
+/**
+ * @brief Sleeps up to ms, waking as soon as the knob queues an event; use it
+ * instead of delay() in loop().
+ * @note After an event LVGL's read timer is made ready, so the next
+ * lv_timer_handler() reads the knob without waiting for its period.
+ */
+void dwin_input_wait(uint32_t ms) {
+#if defined(ESP32)
+  if (wake_task) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms));
+  } else {
+    delay(ms);
+  }
+#else
+  delay(ms);
+#endif
+  if (indev && queue_tail != queue_head) lv_timer_ready(indev->driver->read_timer);
+}
+
+/**
+ * @brief Called when LVGL hands a flush over: it shows the inputs read so far.
+ */
+void dwin_input_flush_begin() {
+  if (read_pending && !flush_pending) {
+    flush_edge_us = read_edge_us;
+    flush_pending = true;
+    read_pending = false;
+  }
+}
+
+/**
+ * @brief Called when a flush has left the transmit ring; may run on the transmit task.
+ */
+void dwin_input_flush_done() {
+  if (!flush_pending) return;
+  flush_pending = false;
+  uint32_t latency = micros() - flush_edge_us;
+  input_stats.latencies++;
+  input_stats.latency_last_us = latency;
+  input_stats.latency_sum_us += latency;
+  input_stats.latency_max_us = max(input_stats.latency_max_us, latency);
+}
+
+const dwin_input_stats_t* dwin_input_get_stats() {
+  return &input_stats;
+}
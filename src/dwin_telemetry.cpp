@@ -0,0 +1,240 @@
+/**
+ * @file dwin_telemetry.cpp
+ * @brief Per-flush timing, byte and encoding counters of the DWIN driver.
+ */
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <dwin.h>
+#include <dwin_encoder.h>
+#include <dwin_telemetry.h>
+
+#if defined(ESP32)
+#include <esp_timer.h>
+#else
+#include <chrono>
+#endif
+
+static dwin_telemetry_t window;
+static dwin_flush_record_t history[DWIN_TELEMETRY_HISTORY];
+static uint8_t history_next = 0;
+static uint8_t history_count = 0;
+#if DWIN_TELEMETRY_REPORT_MS > 0
+static uint32_t last_report_ms = 0;
+#endif
+
+#if DWIN_TELEMETRY
+// The flush being measured. LVGL starts the next flush only once this one is
+// ready, so there is never more than one.
+static bool in_flush = false;
+static dwin_flush_record_t current;
+static uint32_t begin_ticks = 0;
+static uint32_t encoded_ticks = 0;
+static uint64_t encoded_us = 0;           // Wall clock at the end of encoding
+static uint32_t write_ticks = 0;          // Spent writing frames out, while encoding
+static uint32_t encoded_px_before[DWIN_ENC_COUNT];
+
+/**
+ * @brief Free-running time stamp: CPU cycles on the ESP32, nanoseconds on the host.
+ */
+uint32_t dwin_telemetry_ticks() {
+#if defined(ESP32)
+  return ESP.getCycleCount();
+#else
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static uint32_t ticks_to_us(uint32_t ticks) {
+#if defined(ESP32)
+  return ticks / ESP.getCpuFreqMHz();
+#else
+  return ticks / 1000;
+#endif
+}
+
+/**
+ * @brief Microseconds since boot, the same on every core.
+ * @note The drain completes on the transmit task, which may run on another
+ * core than the flush; cycle counts are only compared on one core.
+ */
+static uint64_t wall_us() {
+#if defined(ESP32)
+  return esp_timer_get_time();
+#else
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static void hist_add(uint32_t* hist, uint32_t value) {
+  uint8_t bucket = 0;
+  while (value > 1 && bucket < DWIN_TELEMETRY_BUCKETS - 1) {
+    value >>= 1;
+    bucket++;
+  }
+  hist[bucket]++;
+}
+
+/**
+ * @brief Starts measuring a flush; called before anything is encoded.
+ */
+void dwin_telemetry_flush_begin(const lv_area_t* area) {
+  const dwin_encoder_stats_t* enc = dwin_encoder_get_stats();
+  memset(&current, 0, sizeof(current));
+  current.area = *area;
+  memcpy(encoded_px_before, enc->pixels, sizeof(encoded_px_before));
+  write_ticks = 0;
+  in_flush = true;
+  begin_ticks = dwin_telemetry_ticks();
+}
+
+/**
+ * @brief Marks the end of encoding; the frames may still be in the transmit ring.
+ */
+void dwin_telemetry_flush_encoded() {
+  if (!in_flush) return;
+  encoded_ticks = dwin_telemetry_ticks();
+  encoded_us = wall_us();
+
+  const dwin_encoder_stats_t* enc = dwin_encoder_get_stats();
+  uint32_t most = 0;
+  current.encoding = DWIN_ENC_AUTO;
+  for (uint8_t e = 0; e < DWIN_ENC_COUNT; e++) {
+    uint32_t px = enc->pixels[e] - encoded_px_before[e];
+    if (px > most) {
+      most = px;
+      current.encoding = e;
+    }
+  }
+  current.encode_us = ticks_to_us(encoded_ticks - begin_ticks - write_ticks);
+}
+
+/**
+ * @brief Completes the record once the flush's last byte has left the transmit
+ * ring; may run on the transmit task.
+ */
+void dwin_telemetry_flush_done() {
+  if (!in_flush) return;
+  in_flush = false;
+  current.transmit_us = ticks_to_us(write_ticks) + (uint32_t)(wall_us() - encoded_us);
+
+  history[history_next] = current;
+  history_next = (history_next + 1) % DWIN_TELEMETRY_HISTORY;
+  if (history_count < DWIN_TELEMETRY_HISTORY) history_count++;
+
+  uint32_t px = lv_area_get_size(&current.area);
+  window.flushes++;
+  window.px += px;
+  window.bytes += current.bytes;
+  window.frames += current.frames;
+  window.encode_us += current.encode_us;
+  window.transmit_us += current.transmit_us;
+  window.max_encode_us = max(window.max_encode_us, current.encode_us);
+  window.max_transmit_us = max(window.max_transmit_us, current.transmit_us);
+  if (current.encoding == DWIN_ENC_AUTO) {
+    window.not_encoded++;
+  } else {
+    window.by_encoding[current.encoding]++;
+  }
+  hist_add(window.hist.encode_us, current.encode_us);
+  hist_add(window.hist.transmit_us, current.transmit_us);
+  hist_add(window.hist.bytes, current.bytes);
+  hist_add(window.hist.px, px);
+}
+
+/**
+ * @brief Counts a frame sent by dwin_send_frame().
+ */
+void dwin_telemetry_frame() {
+  if (in_flush) current.frames++;
+}
+
+/**
+ * @brief Accounts a write of the transmit arena.
+ * @param bytes Bytes written or queued.
+ * @param start_ticks dwin_telemetry_ticks() before the write.
+ */
+void dwin_telemetry_write(uint32_t bytes, uint32_t start_ticks) {
+  if (!in_flush) return;
+  current.bytes += bytes;
+  write_ticks += dwin_telemetry_ticks() - start_ticks;
+}
+#endif
+
+/**
+ * @brief Totals and histograms of the flushes since the last report or reset.
+ */
+const dwin_telemetry_t* dwin_telemetry_get() {
+  return &window;
+}
+
+/**
+ * @brief Copies the most recent flush records, newest first.
+ * @return Number of records copied.
+ */
+uint8_t dwin_telemetry_history(dwin_flush_record_t* records, uint8_t max_records) {
+  uint8_t n = min(max_records, history_count);
+  for (uint8_t i = 0; i < n; i++) {
+    records[i] = history[(history_next + DWIN_TELEMETRY_HISTORY - 1 - i) % DWIN_TELEMETRY_HISTORY];
+  }
+  return n;
+}
+
+/**
+ * @brief Starts a new window.
+ */
+void dwin_telemetry_reset() {
+  memset(&window, 0, sizeof(window));
+  window.started_ms = millis();
+}
+
+static void report_hist(const char* name, const uint32_t* hist) {
+  int8_t last = DWIN_TELEMETRY_BUCKETS - 1;
+  while (last > 0 && hist[last] == 0) last--;
+  Serial.printf(" %s", name);
+  for (int8_t i = 0; i <= last; i++) {
+    Serial.printf("%c%lu", i ? ',' : ' ', (unsigned long)hist[i]);
+  }
+}
+
+/**
+ * @brief Prints the window on Serial in two lines and starts a new one.
+ * @details The first line has the totals, the time split and the flushes per
+ * main encoding; the second the log2 histograms (bucket i counts values from
+ * 2^i to 2^(i+1) - 1).
+ */
+void dwin_telemetry_report() {
+  Serial.printf("dwin %lu ms: %lu flushes %lu px %lu B %lu frames | encode %lu us (max %lu) | transmit %lu us (max %lu) |",
+                (unsigned long)(millis() - window.started_ms), (unsigned long)window.flushes,
+                (unsigned long)window.px, (unsigned long)window.bytes, (unsigned long)window.frames,
+                (unsigned long)window.encode_us, (unsigned long)window.max_encode_us,
+                (unsigned long)window.transmit_us, (unsigned long)window.max_transmit_us);
+  for (uint8_t e = 0; e < DWIN_ENC_COUNT; e++) {
+    if (window.by_encoding[e]) {
+      Serial.printf(" %s %lu", dwin_encoding_name((dwin_encoding_t)e), (unsigned long)window.by_encoding[e]);
+    }
+  }
+  Serial.printf(" none %lu\n", (unsigned long)window.not_encoded);
+
+  Serial.printf("dwin log2:");
+  report_hist("encode_us", window.hist.encode_us);
+  report_hist("transmit_us", window.hist.transmit_us);
+  report_hist("bytes", window.hist.bytes);
+  report_hist("px", window.hist.px);
+  Serial.printf("\n");
+
+  dwin_telemetry_reset();
+}
+
+/**
+ * @brief Prints a report every DWIN_TELEMETRY_REPORT_MS; call from loop().
+ */
+void dwin_telemetry_poll() {
+#if DWIN_TELEMETRY_REPORT_MS > 0
+  if (millis() - last_report_ms < DWIN_TELEMETRY_REPORT_MS) return;
+  last_report_ms = millis();
+  if (window.flushes) dwin_telemetry_report();
+#endif
+}
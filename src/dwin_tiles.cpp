@@ -0,0 +1,240 @@
+/**
+ * @file dwin_tiles.cpp
+ * @brief Hash index of the tiles resident in the panel's VRAM, used to copy
+ * repeated content instead of sending it.
+ */
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <dwin.h>
+#include <dwin_tiles.h>
+
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#endif
+
+#define DWIN_TILE_CACHE_SETS (DWIN_TILE_CACHE_ENTRIES / DWIN_TILE_CACHE_WAYS)
+#if DWIN_TILE_CACHE_SETS == 0 || (DWIN_TILE_CACHE_SETS & (DWIN_TILE_CACHE_SETS - 1)) != 0
+#error "DWIN_TILE_CACHE_ENTRIES / DWIN_TILE_CACHE_WAYS must be a power of two"
+#endif
+
+typedef struct {
+  uint64_t hash;          // FNV-1a of the tile's RGB565 pixels, row by row
+  uint32_t last_used;     // Value of use_clock when last indexed or hit
+  uint16_t src_x, src_y;
+  uint8_t page;
+  bool valid;
+} dwin_tile_entry_t;
+
+static dwin_tile_entry_t cache[DWIN_TILE_CACHE_SETS][DWIN_TILE_CACHE_WAYS];
+static uint32_t use_clock = 0;
+static dwin_tile_stats_t tile_stats;
+
+#if defined(ESP32)
+// The index is updated by the LVGL task and looked up by the flush task, a
+// different one with DWIN_DOUBLE_BUFFER: entries are only touched under this lock.
+static portMUX_TYPE tiles_mux = portMUX_INITIALIZER_UNLOCKED;
+#define DWIN_TILES_LOCK() portENTER_CRITICAL(&tiles_mux)
+#define DWIN_TILES_UNLOCK() portEXIT_CRITICAL(&tiles_mux)
+#else
+#define DWIN_TILES_LOCK()
+#define DWIN_TILES_UNLOCK()
+#endif
+
+static const uint64_t FNV64_OFFSET = 14695981039346656037ull;
+static const uint64_t FNV64_PRIME = 1099511628211ull;
+
+// A 64-bit hash is used so a collision (which would show the wrong pixels) is
+// not a practical concern; the pixels behind a hit are never compared.
+static dwin_tile_entry_t* dwin_tiles_set(uint64_t hash) {
+  return cache[(uint32_t)(hash ^ (hash >> 32)) & (DWIN_TILE_CACHE_SETS - 1)];
+}
+
+static dwin_tile_entry_t* dwin_tiles_lookup(uint64_t hash) {
+  dwin_tile_entry_t* set = dwin_tiles_set(hash);
+  for (uint8_t w = 0; w < DWIN_TILE_CACHE_WAYS; w++) {
+    if (set[w].valid && set[w].hash == hash) return &set[w];
+  }
+  return NULL;
+}
+
+/**
+ * @brief Adds VRAM content to the index, one tile at a time.
+ * @param page VRAM page the pixels are in (see dwin_atlas_load()).
+ * @param x Left edge of the region in the page.
+ * @param y Top edge of the region in the page.
+ * @param w Width of the region; whole tiles only, the remainder is ignored.
+ * @param h Height of the region; whole tiles only, the remainder is ignored.
+ * @param px RGB565 pixels of the region, exactly as the page holds them.
+ * @param stride Pixels from one row of px to the next.
+ * @return Number of tiles indexed.
+ * @note Only content drawn at a multiple of DWIN_TILE_SIZE from the region's
+ * origin (and on the screen's tile grid) is found again.
+ */
+uint32_t dwin_tiles_index(uint8_t page, uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                          const uint16_t* px, uint32_t stride) {
+  uint32_t added = 0;
+  for (uint16_t ty = 0; ty + DWIN_TILE_SIZE <= h; ty += DWIN_TILE_SIZE) {
+    for (uint16_t tx = 0; tx + DWIN_TILE_SIZE <= w; tx += DWIN_TILE_SIZE) {
+      const uint16_t* tile = &px[ty * stride + tx];
+      uint64_t hash = FNV64_OFFSET;
+      bool uniform = true;
+      for (uint8_t row = 0; row < DWIN_TILE_SIZE; row++) {
+        for (uint8_t col = 0; col < DWIN_TILE_SIZE; col++) {
+          uint16_t c = tile[row * stride + col];
+          uniform = uniform && c == tile[0];
+          hash = (hash ^ c) * FNV64_PRIME;
+        }
+      }
+      if (uniform) {
+        tile_stats.uniform++;
+        continue;
+      }
+
+      DWIN_TILES_LOCK();
+      dwin_tile_entry_t* entry = dwin_tiles_lookup(hash);
+      if (!entry) {
+        // Free way, or else the least recently used one
+        dwin_tile_entry_t* set = dwin_tiles_set(hash);
+        entry = &set[0];
+        for (uint8_t i = 0; i < DWIN_TILE_CACHE_WAYS && entry->valid; i++) {
+          if (!set[i].valid || set[i].last_used < entry->last_used) entry = &set[i];
+        }
+        if (entry->valid) {
+          tile_stats.evictions++;
+        } else {
+          tile_stats.entries++;
+        }
+      }
+      entry->hash = hash;
+      entry->last_used = ++use_clock;
+      entry->src_x = x + tx;
+      entry->src_y = y + ty;
+      entry->page = page;
+      entry->valid = true;
+      tile_stats.indexed++;
+      DWIN_TILES_UNLOCK();
+      added++;
+    }
+  }
+  return added;
+}
+
+/**
+ * @brief Drops the tiles of a VRAM page, whose content is about to change.
+ */
+void dwin_tiles_forget_page(uint8_t page) {
+  DWIN_TILES_LOCK();
+  for (uint32_t s = 0; s < DWIN_TILE_CACHE_SETS; s++) {
+    for (uint8_t w = 0; w < DWIN_TILE_CACHE_WAYS; w++) {
+      if (cache[s][w].valid && cache[s][w].page == page) {
+        cache[s][w].valid = false;
+        tile_stats.entries--;
+      }
+    }
+  }
+  DWIN_TILES_UNLOCK();
+}
+
+/**
+ * @brief LVGL rounder: aligns redrawn areas to the tile grid while the index holds tiles.
+ * @note LVGL then also cuts its draw buffer into strips of whole tile rows.
+ */
+void dwin_tiles_rounder(lv_disp_drv_t* disp_drv, lv_area_t* area) {
+  if (tile_stats.entries == 0) return;
+  area->x1 = area->x1 / DWIN_TILE_SIZE * DWIN_TILE_SIZE;
+  area->y1 = area->y1 / DWIN_TILE_SIZE * DWIN_TILE_SIZE;
+  area->x2 = min((int32_t)(area->x2 / DWIN_TILE_SIZE + 1) * DWIN_TILE_SIZE - 1, (int32_t)DWIN_WIDTH - 1);
+  area->y2 = min((int32_t)(area->y2 / DWIN_TILE_SIZE + 1) * DWIN_TILE_SIZE - 1, (int32_t)DWIN_HEIGHT - 1);
+}
+
+/**
+ * @brief Looks up the tiles of a flushed area that lie on the tile grid.
+ * @param area Flushed area.
+ * @param color_p Its pixels.
+ * @param hits Filled with the tiles found in VRAM, row by row, left to right.
+ * @param max_hits Size of hits.
+ * @return Number of hits.
+ */
+uint16_t dwin_tiles_match(const lv_area_t* area, const lv_color_t* color_p,
+                          dwin_tile_hit_t* hits, uint16_t max_hits) {
+  if (tile_stats.entries == 0) return 0;
+
+  int32_t width = lv_area_get_width(area);
+  int32_t first_x = (area->x1 + DWIN_TILE_SIZE - 1) / DWIN_TILE_SIZE * DWIN_TILE_SIZE;
+  int32_t first_y = (area->y1 + DWIN_TILE_SIZE - 1) / DWIN_TILE_SIZE * DWIN_TILE_SIZE;
+  uint16_t n = 0;
+
+  for (int32_t ty = first_y; ty + DWIN_TILE_SIZE - 1 <= area->y2; ty += DWIN_TILE_SIZE) {
+    for (int32_t tx = first_x; tx + DWIN_TILE_SIZE - 1 <= area->x2 && n < max_hits; tx += DWIN_TILE_SIZE) {
+      const lv_color_t* tile = &color_p[(ty - area->y1) * width + (tx - area->x1)];
+      uint64_t hash = FNV64_OFFSET;
+      bool uniform = true;
+      for (uint8_t row = 0; row < DWIN_TILE_SIZE; row++) {
+        for (uint8_t col = 0; col < DWIN_TILE_SIZE; col++) {
+          lv_color_t c = tile[row * width + col];
+          uniform = uniform && c.full == tile[0].full;
+          hash = (hash ^ lvgl_to_dwin_color(c)) * FNV64_PRIME;
+        }
+      }
+      if (uniform) continue;   // Never indexed
+
+      DWIN_TILES_LOCK();
+      tile_stats.lookups++;
+      dwin_tile_entry_t* entry = dwin_tiles_lookup(hash);
+      if (entry) {
+        tile_stats.hits++;
+        entry->last_used = ++use_clock;
+        dwin_tile_hit_t* hit = &hits[n++];
+        hit->x = tx;
+        hit->y = ty;
+        hit->page = entry->page;
+        hit->src_x = entry->src_x;
+        hit->src_y = entry->src_y;
+      }
+      DWIN_TILES_UNLOCK();
+    }
+  }
+  return n;
+}
+
+/**
+ * @brief Counts the hits that continue the first one in both the screen and
+ * VRAM, so a single copy covers them.
+ */
+uint16_t dwin_tiles_run(const dwin_tile_hit_t* hits, uint16_t n) {
+  uint16_t run = 1;
+  while (run < n &&
+         hits[run].y == hits[0].y && hits[run].x == hits[0].x + run * DWIN_TILE_SIZE &&
+         hits[run].page == hits[0].page && hits[run].src_y == hits[0].src_y &&
+         hits[run].src_x == hits[0].src_x + run * DWIN_TILE_SIZE) {
+    run++;
+  }
+  return run;
+}
+
+/**
+ * @brief Copies a run of hits (see dwin_tiles_run()) from VRAM onto the screen.
+ */
+void dwin_tiles_copy(const dwin_tile_hit_t* hits, uint16_t n) {
+  dwin_virt_copy_paste(hits->page, hits->src_x, hits->src_y,
+                       hits->src_x + n * DWIN_TILE_SIZE - 1, hits->src_y + DWIN_TILE_SIZE - 1,
+                       hits->x, hits->y);
+  tile_stats.copies++;
+  tile_stats.copied_px += (uint32_t)n * DWIN_TILE_SIZE * DWIN_TILE_SIZE;
+}
+
+const dwin_tile_stats_t* dwin_tiles_get_stats() {
+  return &tile_stats;
+}
+
+/**
+ * @brief Clears the lookup and copy counters, e.g. when switching screens to
+ * measure the hit rate of each one.
+ */
+void dwin_tiles_reset_stats() {
+  tile_stats.lookups = 0;
+  tile_stats.hits = 0;
+  tile_stats.copies = 0;
+  tile_stats.copied_px = 0;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file dwin_trace.cpp
+ * @brief Timestamped capture of the frames sent to the panel.
+ */
+
+#include <Arduino.h>
+#include <dwin.h>
+#include <dwin_trace.h>
+
+static dwin_trace_sink_fn trace_sink = NULL;
+static void* trace_ctx = NULL;
+static uint32_t last_us = 0;
+static dwin_trace_stats_t trace_stats;
+
+static uint8_t put_varint(uint8_t* out, uint32_t value) {
+  uint8_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+/**
+ * @brief Decodes a varint of the trace format.
+ * @return Bytes it took, or 0 if data ends before it does.
+ */
+size_t dwin_trace_read_varint(const uint8_t* data, size_t len, uint32_t* value) {
+  *value = 0;
+  for (size_t i = 0; i < len && i < 5; i++) {
+    *value |= (uint32_t)(data[i] & 0x7F) << (7 * i);
+    if (!(data[i] & 0x80)) return i + 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Starts tracing every frame sent from now on.
+ * @param sink Receives the trace, starting with the header.
+ * @param ctx Passed to the sink.
+ * @param baud Baud rate of the panel UART, recorded for the replay.
+ * @return false if DWIN_TRACE is 0.
+ */
+bool dwin_trace_start(dwin_trace_sink_fn sink, void* ctx, uint32_t baud) {
+  if (!DWIN_TRACE || !sink) return false;
+  uint8_t header[9];
+  memcpy(header, DWIN_TRACE_MAGIC, 4);
+  header[4] = DWIN_TRACE_VERSION;
+  for (uint8_t i = 0; i < 4; i++) {
+    header[5 + i] = (uint8_t)(baud >> (8 * i));
+  }
+  memset(&trace_stats, 0, sizeof(trace_stats));
+  sink(header, sizeof(header), ctx);
+  trace_stats.trace_bytes = sizeof(header);
+  last_us = micros();
+  trace_ctx = ctx;
+  trace_sink = sink;
+  return true;
+}
+
+void dwin_trace_stop() {
+  trace_sink = NULL;
+}
+
+bool dwin_trace_active() {
+  return trace_sink != NULL;
+}
+
+/**
+ * @brief Sink writing the trace to the USB Serial port.
+ * @note The replayer skips anything before the header, such as boot
+ * messages, but nothing else may be printed on Serial while tracing.
+ */
+void dwin_trace_serial_sink(const uint8_t* data, size_t len, void* ctx) {
+  Serial.write(data, len);
+}
+
+#if DWIN_TRACE
+/**
+ * @brief Records a frame; called by dwin_send_frame() with the complete frame.
+ */
+void dwin_trace_frame(const uint8_t* frame, uint32_t len) {
+  dwin_trace_sink_fn sink = trace_sink;
+  if (!sink || len < 5) return;
+
+  uint32_t now = micros();
+  uint8_t head[10];
+  uint8_t n = put_varint(head, now - last_us);
+  n += put_varint(head + n, len - 5);
+  last_us = now;
+
+  sink(head, n, trace_ctx);
+  sink(frame + 1, len - 5, trace_ctx);
+  trace_stats.frames++;
+  trace_stats.frame_bytes += len;
+  trace_stats.trace_bytes += n + len - 5;
+}
+#endif
+
+const dwin_trace_stats_t* dwin_trace_get_stats() {
+  return &trace_stats;
+}
@@ -15,6 +15,18 @@
 #include <Arduino.h>
 #include <lvgl.h>
 #include <dwin.h>
+#include <dwin_encoder.h>
+#include <dwin_draw.h>
+#include <dwin_atlas.h>
+#include <dwin_tiles.h>
+#include <dwin_telemetry.h>
+#include <dwin_input.h>
+
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#endif
 
 //==============================================================================
 // LVGL PORTING CONFIGURATION
@@ -28,80 +40,611 @@ static lv_disp_drv_t disp_drv;
 #define LV_DISP_BUF_SIZE (272 * 20)
 static lv_color_t buf_1[LV_DISP_BUF_SIZE];
 
+// With two draw buffers LVGL renders the next strip into one while the flush
+// task (on the other core) encodes and transmits the previous one.
+#ifndef DWIN_DOUBLE_BUFFER
+#define DWIN_DOUBLE_BUFFER 1
+#endif
+
+#if DWIN_DOUBLE_BUFFER
+static lv_color_t buf_2[LV_DISP_BUF_SIZE];
+#endif
+
 hw_timer_t *lvgl_timer = NULL;
 
+// RAM allowed for the shadow copy of the panel (0 disables it). A full RGB565
+// copy needs DWIN_WIDTH * DWIN_HEIGHT * 2 bytes and is taken from PSRAM when
+// the board has it; smaller budgets keep one 32-bit hash per row cell instead.
+#ifndef DWIN_SHADOW_BUDGET
+#define DWIN_SHADOW_BUDGET 0
+#endif
+
+//==============================================================================
+// SHADOW FRAMEBUFFER
+//==============================================================================
+
+// Exact mode: what the panel shows, plus the span of columns of each row it
+// may show something else (unknown_x1 > unknown_x2 once the row is all known).
+static uint16_t *shadow_px = NULL;
+static int16_t shadow_unknown_x1[DWIN_HEIGHT];
+static int16_t shadow_unknown_x2[DWIN_HEIGHT];
+
+// Hashed mode: one hash per shadow_cell pixels of a row, 0 = unknown.
+static uint32_t *shadow_hash = NULL;
+static uint16_t shadow_cell = 0;
+static uint16_t shadow_cells_per_row = 0;
+
+/**
+ * @brief Allocates the shadow copy of the panel within a RAM budget.
+ * @param budget_bytes Bytes the shadow may use; 0 releases it.
+ * @return true if diffing is active afterwards.
+ * @note Flushes are diffed against the shadow and only changed rows and columns
+ * are encoded. Anything drawn outside LVGL must be followed by dwin_shadow_invalidate().
+ */
+bool dwin_shadow_init(size_t budget_bytes) {
+  free(shadow_px);
+  free(shadow_hash);
+  shadow_px = NULL;
+  shadow_hash = NULL;
+  shadow_cell = 0;
+
+  const size_t exact_bytes = (size_t)DWIN_WIDTH * DWIN_HEIGHT * sizeof(uint16_t);
+  if (budget_bytes >= exact_bytes) {
+#if defined(ESP32)
+    if (psramFound()) shadow_px = (uint16_t *)ps_malloc(exact_bytes);
+#endif
+    if (!shadow_px) shadow_px = (uint16_t *)malloc(exact_bytes);
+  }
+
+  if (!shadow_px && budget_bytes > 0) {
+    // Cells narrower than 2 pixels would cost more than the exact copy.
+    uint16_t cell = 2;
+    while ((size_t)((DWIN_WIDTH + cell - 1) / cell) * DWIN_HEIGHT * sizeof(uint32_t) > budget_bytes && cell < DWIN_WIDTH) {
+      cell *= 2;
+    }
+    shadow_cells_per_row = (DWIN_WIDTH + cell - 1) / cell;
+    size_t hash_bytes = (size_t)shadow_cells_per_row * DWIN_HEIGHT * sizeof(uint32_t);
+    if (hash_bytes <= budget_bytes) {
+      shadow_hash = (uint32_t *)malloc(hash_bytes);
+      if (shadow_hash) shadow_cell = cell;
+    }
+  }
+
+  dwin_shadow_invalidate();
+  return shadow_px != NULL || shadow_hash != NULL;
+}
+
+/**
+ * @brief Forgets the panel contents so the next flush of every pixel is sent in full.
+ */
+void dwin_shadow_invalidate() {
+  for (int32_t y = 0; y < DWIN_HEIGHT; y++) {
+    shadow_unknown_x1[y] = 0;
+    shadow_unknown_x2[y] = DWIN_WIDTH - 1;
+  }
+  if (shadow_hash) {
+    memset(shadow_hash, 0, (size_t)shadow_cells_per_row * DWIN_HEIGHT * sizeof(uint32_t));
+  }
+}
+
+/**
+ * @brief Adds columns x1..x2 of row y to its unknown span (the span grows to cover both).
+ */
+static void dwin_shadow_forget(int32_t y, int32_t x1, int32_t x2) {
+  if (x1 > x2) return;
+  if (shadow_unknown_x1[y] > shadow_unknown_x2[y]) {
+    shadow_unknown_x1[y] = x1;
+    shadow_unknown_x2[y] = x2;
+  } else {
+    shadow_unknown_x1[y] = min((int32_t)shadow_unknown_x1[y], x1);
+    shadow_unknown_x2[y] = max((int32_t)shadow_unknown_x2[y], x2);
+  }
+}
+
+/**
+ * @brief Forgets the panel contents under an area drawn without going through the shadow.
+ * @note The exact shadow forgets the columns touched in each row, the hashed
+ * one the cells touched.
+ */
+void dwin_shadow_invalidate_area(const lv_area_t *area) {
+  int32_t y1 = max((int32_t)area->y1, (int32_t)0);
+  int32_t y2 = min((int32_t)area->y2, (int32_t)DWIN_HEIGHT - 1);
+  int32_t x1 = max((int32_t)area->x1, (int32_t)0);
+  int32_t x2 = min((int32_t)area->x2, (int32_t)DWIN_WIDTH - 1);
+  if (x1 > x2) return;
+
+  for (int32_t y = y1; y <= y2; y++) {
+    dwin_shadow_forget(y, x1, x2);
+    if (shadow_hash) {
+      uint32_t *hashes = &shadow_hash[y * shadow_cells_per_row];
+      for (int32_t c = x1 / shadow_cell; c <= x2 / shadow_cell; c++) hashes[c] = 0;
+    }
+  }
+}
+
+static bool dwin_shadow_active() {
+  return shadow_px != NULL || shadow_hash != NULL;
+}
+
+/**
+ * @brief FNV-1a hash of a run of pixels; never returns 0 (reserved for unknown cells).
+ */
+static uint32_t dwin_shadow_hash_run(const lv_color_t *px, int32_t n) {
+  uint32_t h = 2166136261u;
+  for (int32_t i = 0; i < n; i++) {
+    h = (h ^ px[i].full) * 16777619u;
+  }
+  return h ? h : 1;
+}
+
+/**
+ * @brief Finds the changed columns of one row and updates the shadow.
+ * @param row Pixels of the row inside the flush area.
+ * @param x1 First column of the flush area.
+ * @param x2 Last column of the flush area.
+ * @param y Panel row.
+ * @param changed_x1 Set to the first changed column.
+ * @param changed_x2 Set to the last changed column.
+ * @return true if any pixel of the row has to be sent.
+ */
+static bool dwin_shadow_diff_row(const lv_color_t *row, int32_t x1, int32_t x2, int32_t y,
+                                 int32_t *changed_x1, int32_t *changed_x2) {
+  int32_t first = INT32_MAX;
+  int32_t last = -1;
+
+  if (shadow_px) {
+    uint16_t *shadow_row = &shadow_px[y * DWIN_WIDTH];
+    int32_t ux1 = shadow_unknown_x1[y];
+    int32_t ux2 = shadow_unknown_x2[y];
+    for (int32_t x = x1; x <= x2; x++) {
+      if (shadow_row[x] != row[x - x1].full || (x >= ux1 && x <= ux2)) {
+        if (first == INT32_MAX) first = x;
+        last = x;
+      }
+    }
+
+    // The flushed columns are known from now on; a flush strictly inside the
+    // unknown span would split it and leaves it as it is.
+    if (ux1 <= ux2 && x1 <= ux2 && x2 >= ux1) {
+      if (x1 <= ux1 && x2 >= ux2) {
+        shadow_unknown_x1[y] = 1;
+        shadow_unknown_x2[y] = 0;
+      } else if (x1 <= ux1) {
+        shadow_unknown_x1[y] = x2 + 1;
+      } else if (x2 >= ux2) {
+        shadow_unknown_x2[y] = x1 - 1;
+      }
+    }
+    for (int32_t x = first; x <= last; x++) {
+      shadow_row[x] = row[x - x1].full;
+    }
+  } else {
+    uint32_t *hashes = &shadow_hash[y * shadow_cells_per_row];
+    for (int32_t c = x1 / shadow_cell; c <= x2 / shadow_cell; c++) {
+      int32_t cx1 = c * shadow_cell;
+      int32_t cx2 = min(cx1 + shadow_cell - 1, (int32_t)DWIN_WIDTH - 1);
+      bool changed;
+      if (cx1 >= x1 && cx2 <= x2) {
+        uint32_t h = dwin_shadow_hash_run(&row[cx1 - x1], cx2 - cx1 + 1);
+        changed = hashes[c] != h;
+        hashes[c] = h;
+      } else {
+        // The flush only covers part of the cell: send it and forget the cell.
+        changed = true;
+        hashes[c] = 0;
+      }
+      if (changed) {
+        if (first == INT32_MAX) first = max(cx1, x1);
+        last = min(cx2, x2);
+      }
+    }
+  }
+
+  *changed_x1 = first;
+  *changed_x2 = last;
+  return last >= 0;
+}
+
+typedef bool (*dwin_diff_row_fn)(const lv_color_t *row, int32_t x1, int32_t x2, int32_t y,
+                                 int32_t *changed_x1, int32_t *changed_x2);
+
+/**
+ * @brief Diff function for when nothing is known about the panel: every pixel is sent.
+ */
+static bool dwin_full_diff_row(const lv_color_t *row, int32_t x1, int32_t x2, int32_t y,
+                               int32_t *changed_x1, int32_t *changed_x2) {
+  *changed_x1 = x1;
+  *changed_x2 = x2;
+  return true;
+}
+
+/**
+ * @brief Encodes only what differs from the panel, as bands of consecutive changed rows.
+ * @param area Part of the flushed area to encode.
+ * @param color_p Pixels of its first row.
+ * @param stride Pixels from one row to the next (the flushed area's width).
+ * @param diff_row Compares one row with what the panel shows (the shadow, or
+ * the primitives just drawn natively).
+ */
+static void dwin_flush_changed(const lv_area_t *area, const lv_color_t *color_p, int32_t stride,
+                               dwin_diff_row_fn diff_row) {
+  int32_t band_y1 = -1, band_x1 = 0, band_x2 = 0;
+
+  for (int32_t y = area->y1; y <= area->y2 + 1; y++) {
+    int32_t x1, x2;
+    bool changed = y <= area->y2 &&
+                   diff_row(&color_p[(y - area->y1) * stride], area->x1, area->x2, y, &x1, &x2);
+    if (changed && band_y1 < 0) {
+      band_y1 = y;
+      band_x1 = x1;
+      band_x2 = x2;
+    } else if (changed) {
+      band_x1 = min(band_x1, x1);
+      band_x2 = max(band_x2, x2);
+    } else if (band_y1 >= 0) {
+      const lv_color_t *px = &color_p[(band_y1 - area->y1) * stride + (band_x1 - area->x1)];
+      dwin_encode_block(px, stride, band_x1, band_y1, band_x2 - band_x1 + 1, y - band_y1);
+      band_y1 = -1;
+    }
+  }
+}
+
+// Tiles of the flushing area found in VRAM (at most one per tile of a draw buffer).
+static dwin_tile_hit_t tile_hits[LV_DISP_BUF_SIZE / (DWIN_TILE_SIZE * DWIN_TILE_SIZE) + 1];
+
+/**
+ * @brief Encodes a flushed area whose tiles were looked up in the tile cache:
+ * tiles found in VRAM are copied from there, the pixels around them are
+ * encoded as usual.
+ * @note Areas are aligned to the tile grid by dwin_tiles_rounder(), so each
+ * strip of DWIN_TILE_SIZE rows is split into columns around its hits.
+ */
+static void dwin_flush_tiles(const lv_area_t *area, const lv_color_t *color_p, uint16_t hits,
+                             dwin_diff_row_fn diff_row) {
+  int32_t width = lv_area_get_width(area);
+  uint16_t h = 0;
+
+  for (int32_t y1 = area->y1; y1 <= area->y2;) {
+    int32_t y2 = min((y1 / DWIN_TILE_SIZE + 1) * DWIN_TILE_SIZE - 1, (int32_t)area->y2);
+    int32_t x = area->x1;
+
+    while (x <= area->x2) {
+      bool on_hit = h < hits && tile_hits[h].y == y1;
+      int32_t x2 = on_hit ? tile_hits[h].x - 1 : area->x2;
+      if (x <= x2) {
+        lv_area_t part = {(lv_coord_t)x, (lv_coord_t)y1, (lv_coord_t)x2, (lv_coord_t)y2};
+        dwin_flush_changed(&part, &color_p[(y1 - area->y1) * width + (x - area->x1)], width, diff_row);
+      }
+      if (!on_hit) break;
+
+      // The diff still runs over the tiles so the shadow learns their pixels;
+      // tiles the panel already shows are not copied again.
+      uint16_t run = dwin_tiles_run(&tile_hits[h], hits - h);
+      int32_t run_x1 = tile_hits[h].x;
+      int32_t run_x2 = run_x1 + run * DWIN_TILE_SIZE - 1;
+      bool changed = false;
+      for (int32_t y = y1; y <= y2; y++) {
+        int32_t cx1, cx2;
+        changed |= diff_row(&color_p[(y - area->y1) * width + (run_x1 - area->x1)], run_x1, run_x2, y, &cx1, &cx2);
+      }
+      if (changed) dwin_tiles_copy(&tile_hits[h], run);
+      h += run;
+      x = run_x2 + 1;
+    }
+    y1 = y2 + 1;
+  }
+}
+
+//==============================================================================
+// HARDWARE SCROLLING
+//==============================================================================
+// LVGL redraws the whole container on every scroll step. The panel shifts the
+// old content with CMD_MOVE_AREA and the shadow is shifted the same way, so
+// the diff of the redrawn container only sends the newly exposed strip.
+
+#ifndef DWIN_SCROLL_QUEUE
+#define DWIN_SCROLL_QUEUE 8
+#endif
+
+typedef struct {
+  lv_area_t area;
+  int16_t dx;               // Content movement, positive = right / down
+  int16_t dy;
+  uint16_t color;           // Background shown in the vacated strip
+  uint32_t before_flush;    // Sequence number of the first flush drawn after the scroll
+} dwin_scroll_move_t;
+
+typedef struct {
+  lv_coord_t x;
+  lv_coord_t y;
+} dwin_scroll_pos_t;
+
+// Filled by LVGL, emptied by whichever task flushes; one writer per index.
+static dwin_scroll_move_t scroll_moves[DWIN_SCROLL_QUEUE];
+static volatile uint8_t scroll_head = 0;
+static volatile uint8_t scroll_tail = 0;
+static volatile uint32_t flush_seq = 0;
+static uint32_t scroll_moves_sent = 0;
+
+/**
+ * @brief Shifts the shadow rows or columns of an area like CMD_MOVE_AREA does on the panel.
+ */
+static void dwin_shadow_move(const lv_area_t *a, int32_t dx, int32_t dy, uint16_t color) {
+  int32_t w = lv_area_get_width(a);
+  int32_t h = lv_area_get_height(a);
+
+  if (dy != 0) {
+    // Walk against the movement so rows are read before they are overwritten.
+    for (int32_t i = 0; i < h; i++) {
+      int32_t y = dy > 0 ? a->y2 - i : a->y1 + i;
+      int32_t src = y - dy;
+      bool inside = src >= a->y1 && src <= a->y2;
+      if (shadow_px) {
+        uint16_t *row = &shadow_px[y * DWIN_WIDTH + a->x1];
+        if (inside) {
+          memcpy(row, &shadow_px[src * DWIN_WIDTH + a->x1], w * sizeof(uint16_t));
+          dwin_shadow_forget(y, max((int32_t)shadow_unknown_x1[src], (int32_t)a->x1),
+                             min((int32_t)shadow_unknown_x2[src], (int32_t)a->x2));
+        } else {
+          for (int32_t x = 0; x < w; x++) row[x] = color;
+        }
+      } else {
+        // Only cells lying entirely inside the area move with it.
+        uint32_t *hashes = &shadow_hash[y * shadow_cells_per_row];
+        for (int32_t c = a->x1 / shadow_cell; c <= a->x2 / shadow_cell; c++) {
+          bool whole = c * shadow_cell >= a->x1 && (c + 1) * shadow_cell - 1 <= a->x2;
+          hashes[c] = inside && whole ? shadow_hash[src * shadow_cells_per_row + c] : 0;
+        }
+      }
+    }
+  }
+
+  if (dx != 0) {
+    for (int32_t y = a->y1; y <= a->y2; y++) {
+      if (shadow_px) {
+        uint16_t *row = &shadow_px[y * DWIN_WIDTH];
+        for (int32_t i = 0; i < w; i++) {
+          int32_t x = dx > 0 ? a->x2 - i : a->x1 + i;
+          int32_t src = x - dx;
+          row[x] = src >= a->x1 && src <= a->x2 ? row[src] : color;
+        }
+        // Unknown columns inside the area move with it.
+        int32_t ux1 = max((int32_t)shadow_unknown_x1[y], (int32_t)a->x1);
+        int32_t ux2 = min((int32_t)shadow_unknown_x2[y], (int32_t)a->x2);
+        if (ux1 <= ux2) {
+          dwin_shadow_forget(y, max(ux1 + dx, (int32_t)a->x1), min(ux2 + dx, (int32_t)a->x2));
+        }
+      } else {
+        uint32_t *hashes = &shadow_hash[y * shadow_cells_per_row];
+        for (int32_t c = a->x1 / shadow_cell; c <= a->x2 / shadow_cell; c++) hashes[c] = 0;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Sends the scroll moves recorded before a flush, in order.
+ * @param seq Sequence number of the flush about to be encoded.
+ */
+static void dwin_scroll_apply(uint32_t seq) {
+  while (scroll_tail != scroll_head) {
+    const dwin_scroll_move_t *m = &scroll_moves[scroll_tail];
+    if ((int32_t)(m->before_flush - seq) > 0) break;
+    const lv_area_t *a = &m->area;
+
+    if (dwin_shadow_active()) {
+      if (m->dy != 0) {
+        dwin_move_area(0x01, m->dy > 0 ? 0x03 : 0x02, abs(m->dy), m->color, a->x1, a->y1, a->x2, a->y2);
+        dwin_shadow_move(a, 0, m->dy, m->color);
+        scroll_moves_sent++;
+      }
+      if (m->dx != 0) {
+        dwin_move_area(0x01, m->dx > 0 ? 0x01 : 0x00, abs(m->dx), m->color, a->x1, a->y1, a->x2, a->y2);
+        dwin_shadow_move(a, m->dx, 0, m->color);
+        scroll_moves_sent++;
+      }
+    }
+    scroll_tail = (scroll_tail + 1) % DWIN_SCROLL_QUEUE;
+  }
+}
+
+/**
+ * @brief LV_EVENT_SCROLL handler: records how far the content moved on the panel.
+ */
+static void dwin_scroll_event_cb(lv_event_t *e) {
+  lv_obj_t *obj = lv_event_get_target(e);
+  dwin_scroll_pos_t *pos = (dwin_scroll_pos_t *)lv_event_get_user_data(e);
+  if (lv_event_get_code(e) == LV_EVENT_DELETE) {
+    free(pos);
+    return;
+  }
+
+  lv_coord_t x = lv_obj_get_scroll_x(obj);
+  lv_coord_t y = lv_obj_get_scroll_y(obj);
+  int32_t dx = pos->x - x;
+  int32_t dy = pos->y - y;
+  pos->x = x;
+  pos->y = y;
+  if ((dx == 0 && dy == 0) || !dwin_shadow_active()) return;
+
+  // A gradient or image background does not move with the content.
+  if (lv_obj_get_style_bg_grad_dir(obj, LV_PART_MAIN) != LV_GRAD_DIR_NONE ||
+      lv_obj_get_style_bg_img_src(obj, LV_PART_MAIN) != NULL) {
+    return;
+  }
+
+  // Move what is visible inside the border; the border itself stays put.
+  lv_area_t area;
+  lv_obj_get_coords(obj, &area);
+  lv_coord_t border = lv_obj_get_style_border_width(obj, LV_PART_MAIN);
+  lv_area_increase(&area, -border, -border);
+  if (!lv_obj_area_is_visible(obj, &area)) return;
+  if (abs(dx) >= lv_area_get_width(&area) || abs(dy) >= lv_area_get_height(&area)) return;
+
+  // A full queue only means this step is sent as pixels.
+  uint8_t next = (scroll_head + 1) % DWIN_SCROLL_QUEUE;
+  if (next == scroll_tail) return;
+  dwin_scroll_move_t *m = &scroll_moves[scroll_head];
+  m->area = area;
+  m->dx = dx;
+  m->dy = dy;
+  m->color = lvgl_to_dwin_color(lv_obj_get_style_bg_color(obj, LV_PART_MAIN));
+  m->before_flush = flush_seq + 1;
+  scroll_head = next;
+}
+
+/**
+ * @brief Scrolls an object's content with CMD_MOVE_AREA instead of resending it.
+ * @param obj A scrollable container with a flat background.
+ * @note Needs the shadow framebuffer (DWIN_SHADOW_BUDGET); without it the
+ * container is resent as before.
+ */
+void dwin_scroll_attach(lv_obj_t *obj) {
+  dwin_scroll_pos_t *pos = (dwin_scroll_pos_t *)malloc(sizeof(dwin_scroll_pos_t));
+  if (!pos) return;
+  pos->x = lv_obj_get_scroll_x(obj);
+  pos->y = lv_obj_get_scroll_y(obj);
+  lv_obj_add_event_cb(obj, dwin_scroll_event_cb, LV_EVENT_SCROLL, pos);
+  lv_obj_add_event_cb(obj, dwin_scroll_event_cb, LV_EVENT_DELETE, pos);
+}
+
+/**
+ * @brief Number of CMD_MOVE_AREA frames sent for scrolling.
+ */
+uint32_t dwin_scroll_moves() {
+  return scroll_moves_sent;
+}
+
 //==============================================================================
 // LVGL PORTING LAYER
 //==============================================================================
 
+// Render/transmit overlap accounting. A flush is busy from the moment LVGL hands
+// it over until its bytes have left the transmit ring; the part of that time
+// LVGL did not spend in dwin_disp_wait() it was rendering in parallel.
+static volatile uint32_t flush_started_us = 0;
+static dwin_pipeline_stats_t pipeline_stats;
+
+#if defined(ESP32) && DWIN_DOUBLE_BUFFER
+typedef struct {
+  lv_disp_drv_t *disp_drv;
+  lv_area_t area;
+  lv_color_t *color_p;
+  uint32_t seq;
+} dwin_flush_job_t;
+
+static QueueHandle_t flush_queue = NULL;
+static TaskHandle_t flush_task = NULL;
+#endif
+
+/**
+ * @brief Completes an LVGL flush; may run on the DWIN transmit task.
+ */
+static void dwin_flush_done(void *arg) {
+  pipeline_stats.busy_us += micros() - flush_started_us;
+  dwin_telemetry_flush_done();
+  dwin_input_flush_done();
+  lv_disp_flush_ready((lv_disp_drv_t *)arg);
+}
+
+/**
+ * @brief Encodes one flushed area and queues its frames.
+ * @note This is the heart of the driver. It takes pixel data from LVGL and
+ * sends the corresponding DWIN commands. The performance bottleneck is here.
+ */
+static void dwin_flush_area(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p, uint32_t seq) {
+  int32_t width = lv_area_get_width(area);
+  int32_t height = lv_area_get_height(area);
+
+  dwin_telemetry_flush_begin(area);
+  dwin_begin_batch();
+  dwin_scroll_apply(seq);
+
+  // The shadow already skips unchanged fills; native primitives are dropped.
+  dwin_diff_row_fn diff_row = NULL;
+  if (dwin_shadow_active()) {
+    diff_row = dwin_shadow_diff_row;
+  } else if (dwin_draw_native_begin(color_p)) {
+    diff_row = dwin_draw_native_diff_row;
+  }
+
+  // Tiles are matched on LVGL's exact pixels, before quantization.
+  uint16_t hits = dwin_tiles_match(area, color_p, tile_hits, sizeof(tile_hits) / sizeof(tile_hits[0]));
+  dwin_quantize_area(color_p, width, width, height);
+  if (hits) {
+    dwin_flush_tiles(area, color_p, hits, diff_row ? diff_row : dwin_full_diff_row);
+  } else if (diff_row) {
+    dwin_flush_changed(area, color_p, width, diff_row);
+  } else {
+    dwin_encode_block(color_p, width, area->x1, area->y1, width, height);
+  }
+  dwin_draw_native_end(color_p);
+  dwin_end_batch();
+  dwin_telemetry_flush_encoded();
+
+  // Tell LVGL that we are done flushing and it can send the next chunk, once
+  // the frames have actually left the transmit ring.
+  dwin_tx_when_drained(dwin_flush_done, disp_drv);
+}
+
+#if defined(ESP32) && DWIN_DOUBLE_BUFFER
+/**
+ * @brief Encodes and transmits flushed buffers on the core LVGL does not run on.
+ */
+static void dwin_flush_task(void *param) {
+  dwin_flush_job_t job;
+  for (;;) {
+    if (xQueueReceive(flush_queue, &job, portMAX_DELAY) == pdTRUE) {
+      dwin_flush_area(job.disp_drv, &job.area, job.color_p, job.seq);
+    }
+  }
+}
+#endif
+
 /**
  * @brief LVGL display flush callback.
  * @param disp_drv Pointer to the LVGL display driver.
  * @param area The rectangular area to be updated.
  * @param color_p Pointer to the buffer containing the pixel data.
- * @note This function is the heart of the driver. It takes pixel data from LVGL
- * and sends the corresponding DWIN commands. The performance bottleneck is here.
+ * @note With the flush task running this only hands the buffer over and returns,
+ * so LVGL can start rendering into the other draw buffer straight away.
  */
 static void dwin_disp_flush(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p) {
-  int32_t width = lv_area_get_width(area);
-  int32_t height = lv_area_get_height(area);
+  pipeline_stats.flushes++;
+  flush_started_us = micros();
+  dwin_input_flush_begin();
+  uint32_t seq = ++flush_seq;
 
-  // DWIN command pattern explanation for CMD_DRAW_RECT (0x05):
-  // FRAME_HEADER | CMD | Mode | Color (2B) | X_start (2B) | Y_start (2B) | X_end (2B) | Y_end (2B) | FRAME_TAIL
-  // AA 05 01 F8 00 00 64 00 64 00 C8 00 C8 CC 33 C3 3C -> Fills a red square at (100,100) of size 100x100.
-
-  // Optimization for solid color areas (e.g., backgrounds, buttons without gradients).
-  // This is the MOST EFFICIENT way to draw with this display.
-  bool is_solid = true;
-  lv_color_t first_color = *color_p;
-  for (int32_t i = 1; i < width * height; i++) {
-    if (color_p[i].full != first_color.full) {
-      is_solid = false;
-      break;
-    }
+#if defined(ESP32) && DWIN_DOUBLE_BUFFER
+  if (flush_task) {
+    dwin_flush_job_t job = {disp_drv, *area, color_p, seq};
+    xQueueSend(flush_queue, &job, portMAX_DELAY);
+    return;
   }
+#endif
+  // Encoding inline blocks LVGL just like waiting does.
+  dwin_flush_area(disp_drv, area, color_p, seq);
+  pipeline_stats.wait_us += micros() - flush_started_us;
+}
 
-  if (is_solid) {
-    uint16_t dwin_color = lvgl_to_dwin_color(first_color);
-    dwin_start_frame();
-    dwin_add_byte(CMD_DRAW_RECT); // Command 0x05: Draw Rectangle
-    dwin_add_byte(0x01);          // Mode 0x01: Fill the area
-    dwin_add_word(dwin_color);
-    dwin_add_word(area->x1);
-    dwin_add_word(area->y1);
-    dwin_add_word(area->x2);
-    dwin_add_word(area->y2);
-    dwin_send_frame();
-  } 
-  // Fallback for multi-color areas (gradients, text, images).
-  // THIS IS EXTREMELY SLOW and will be the main performance bottleneck.
-  // We send each pixel one by one. The original code tried to optimize this by sending
-  // small rectangles, but that also sends too many commands. This is more direct,
-  // but still not fast enough for a fluid UI.
-  else {
-    for (int32_t y = 0; y < height; y++) {
-      for (int32_t x = 0; x < width; x++) {
-        uint16_t dwin_color = lvgl_to_dwin_color(*color_p);
-        
-        // DWIN command pattern explanation for CMD_SET_POINT (0x02):
-        // FRAME_HEADER | CMD | Color(2B) | Nx | Ny | X0(2B) | Y0(2B) | ... | FRAME_TAIL
-        // Using Nx=1, Ny=1 to draw a single pixel.
-        dwin_start_frame();
-        dwin_add_byte(CMD_SET_POINT); // Command 0x02: Set Point
-        dwin_add_word(dwin_color);    // Color of the pixel
-        dwin_add_byte(0x01);          // Nx: 1 pixel width
-        dwin_add_byte(0x01);          // Ny: 1 pixel height
-        dwin_add_word(area->x1 + x);  // Absolute X coordinate
-        dwin_add_word(area->y1 + y);  // Absolute Y coordinate
-        dwin_send_frame();
-        
-        color_p++; // Move to the next pixel in the buffer
-      }
-    }
-  }
+/**
+ * @brief Lets other tasks run while LVGL waits for a flush to drain.
+ */
+static void dwin_disp_wait(lv_disp_drv_t *disp_drv) {
+  uint32_t start = micros();
+  delay(1);
+  pipeline_stats.wait_us += micros() - start;
+}
 
-  // Tell LVGL that we are done flushing and it can send the next chunk.
-  lv_disp_flush_ready(disp_drv);
+/**
+ * @brief Copies the render/transmit pipeline counters.
+ * @param stats Destination; overlap_us is the time LVGL rendered while a flush
+ * was still being encoded or transmitted.
+ */
+void dwin_pipeline_get_stats(dwin_pipeline_stats_t *stats) {
+  *stats = pipeline_stats;
+  stats->overlap_us = pipeline_stats.busy_us > pipeline_stats.wait_us ?
+                      pipeline_stats.busy_us - pipeline_stats.wait_us : 0;
 }
 
 /**
@@ -123,10 +666,15 @@ void lvgl_driver_init() {
 
   // Initialize LVGL Core
   lv_init();
+  dwin_atlas_init();
   dwin_draw_setup_string(10, 30, COLOR_WHITE, "LVGL Core Initialized.");
 
   // Initialize LVGL Display Buffer
+#if DWIN_DOUBLE_BUFFER
+  lv_disp_draw_buf_init(&disp_buf, buf_1, buf_2, LV_DISP_BUF_SIZE);
+#else
   lv_disp_draw_buf_init(&disp_buf, buf_1, NULL, LV_DISP_BUF_SIZE);
+#endif
   dwin_draw_setup_string(10, 50, COLOR_WHITE, "LVGL Draw Buffer Ready.");
 
   // Initialize and Register Display Driver
@@ -134,7 +682,26 @@ void lvgl_driver_init() {
   disp_drv.hor_res = 272; // Horizontal resolution after 90-degree rotation
   disp_drv.ver_res = 480; // Vertical resolution after 90-degree rotation
   disp_drv.flush_cb = dwin_disp_flush;
+  disp_drv.wait_cb = dwin_disp_wait;
+  disp_drv.draw_ctx_init = dwin_draw_ctx_init;
+  disp_drv.draw_ctx_deinit = dwin_draw_ctx_deinit;
+  disp_drv.draw_ctx_size = sizeof(lv_draw_sw_ctx_t);
+  disp_drv.rounder_cb = dwin_tiles_rounder;
   disp_drv.draw_buf = &disp_buf;
   lv_disp_drv_register(&disp_drv);
   dwin_draw_setup_string(10, 70, COLOR_WHITE, "DWIN Driver Registered.");
+
+  if (dwin_shadow_init(DWIN_SHADOW_BUDGET)) {
+    dwin_draw_setup_string(10, 90, COLOR_WHITE, "Shadow Framebuffer Enabled.");
+  }
+
+#if defined(ESP32) && DWIN_DOUBLE_BUFFER
+  // LVGL runs in loop() on core 1; encoding and transmit move to core 0.
+  // Direct dwin_draw_*/dwin_atlas_* calls from loop() wait for the flush's
+  // frame batch to end (frame lock in dwin.cpp), so they can still be used.
+  flush_queue = xQueueCreate(1, sizeof(dwin_flush_job_t));
+  if (flush_queue) {
+    xTaskCreatePinnedToCore(dwin_flush_task, "dwin_flush", 4096, NULL, 1, &flush_task, 0);
+  }
+#endif
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include <Arduino.h>
 #include <HardwareSerial.h>
 #include <dwin.h>
+#include <dwin_telemetry.h>
+#include <dwin_trace.h>
+#include <dwin_input.h>
 #include <lvgl.h>
 
 //==============================================================================
@@ -12,6 +15,11 @@ HardwareSerial DWINSerial(2);
 #define DWIN_TX_PIN 17
 #define DWIN_BAUD_RATE 115200
 
+// 1 streams a wire trace of the session on Serial instead of log messages
+#ifndef DWIN_TRACE_SERIAL
+#define DWIN_TRACE_SERIAL 0
+#endif
+
 //==============================================================================
 // MAIN APPLICATION LOGIC
 //==============================================================================
@@ -57,9 +65,13 @@ void create_test_hmi() {
 void setup() {
   Serial.begin(DWIN_BAUD_RATE);
   DWINSerial.begin(DWIN_BAUD_RATE, SERIAL_8N1, DWIN_RX_PIN, DWIN_TX_PIN);
+  dwin_tx_begin();
 
   delay(500);
   Serial.println("\n--- DWIN LVGL Driver Initialization ---");
+  if (!dwin_handshake(500)) {
+    Serial.println("No handshake answer from the panel (RX wire?); pacing with fixed delays.");
+  }
   dwin_draw_setup_string(10, 10, COLOR_WHITE, "Serial Ports Initialized.");
 
   // Set Screen Orientation to 90 degrees
@@ -76,6 +88,7 @@ void setup() {
   
   // Initialize LVGL
   lvgl_driver_init();
+  dwin_input_init();
   dwin_draw_setup_string(10, 130, COLOR_GREEN, "LVGL Setup Complete. Starting HMI...");
   delay(1000);
   
@@ -83,6 +96,11 @@ void setup() {
   create_test_hmi();
 
   Serial.println("Initialization complete. Running LVGL handler.");
+
+#if DWIN_TRACE_SERIAL
+  // From here on Serial carries the binary trace; capture it for dwin_bench --replay.
+  dwin_trace_start(dwin_trace_serial_sink, NULL, DWIN_BAUD_RATE);
+#endif
 }
 
 /**
@@ -90,5 +108,6 @@ void setup() {
  */
 void loop() {
   lv_timer_handler();
-  delay(5);
+  dwin_telemetry_poll();
+  dwin_input_wait(5);
 }
\ No newline at end of file